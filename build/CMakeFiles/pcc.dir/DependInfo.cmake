@@ -0,0 +1,41 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/codegen.cpp" "CMakeFiles/pcc.dir/codegen.cpp.o" "gcc" "CMakeFiles/pcc.dir/codegen.cpp.o.d"
+  "/root/repo/gen_ir.cpp" "CMakeFiles/pcc.dir/gen_ir.cpp.o" "gcc" "CMakeFiles/pcc.dir/gen_ir.cpp.o.d"
+  "/root/repo/ir_core/BasicBlock.cpp" "CMakeFiles/pcc.dir/ir_core/BasicBlock.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/BasicBlock.cpp.o.d"
+  "/root/repo/ir_core/Constant.cpp" "CMakeFiles/pcc.dir/ir_core/Constant.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/Constant.cpp.o.d"
+  "/root/repo/ir_core/Function.cpp" "CMakeFiles/pcc.dir/ir_core/Function.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/Function.cpp.o.d"
+  "/root/repo/ir_core/GlobalObject.cpp" "CMakeFiles/pcc.dir/ir_core/GlobalObject.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/GlobalObject.cpp.o.d"
+  "/root/repo/ir_core/GlobalVariable.cpp" "CMakeFiles/pcc.dir/ir_core/GlobalVariable.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/GlobalVariable.cpp.o.d"
+  "/root/repo/ir_core/IRContext.cpp" "CMakeFiles/pcc.dir/ir_core/IRContext.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/IRContext.cpp.o.d"
+  "/root/repo/ir_core/IRPrinter.cpp" "CMakeFiles/pcc.dir/ir_core/IRPrinter.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/IRPrinter.cpp.o.d"
+  "/root/repo/ir_core/Instruction.cpp" "CMakeFiles/pcc.dir/ir_core/Instruction.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/Instruction.cpp.o.d"
+  "/root/repo/ir_core/Module.cpp" "CMakeFiles/pcc.dir/ir_core/Module.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/Module.cpp.o.d"
+  "/root/repo/ir_core/Value.cpp" "CMakeFiles/pcc.dir/ir_core/Value.cpp.o" "gcc" "CMakeFiles/pcc.dir/ir_core/Value.cpp.o.d"
+  "/root/repo/main.cpp" "CMakeFiles/pcc.dir/main.cpp.o" "gcc" "CMakeFiles/pcc.dir/main.cpp.o.d"
+  "/root/repo/parse.cpp" "CMakeFiles/pcc.dir/parse.cpp.o" "gcc" "CMakeFiles/pcc.dir/parse.cpp.o.d"
+  "/root/repo/passes/dce.cpp" "CMakeFiles/pcc.dir/passes/dce.cpp.o" "gcc" "CMakeFiles/pcc.dir/passes/dce.cpp.o.d"
+  "/root/repo/passes/gvn.cpp" "CMakeFiles/pcc.dir/passes/gvn.cpp.o" "gcc" "CMakeFiles/pcc.dir/passes/gvn.cpp.o.d"
+  "/root/repo/passes/mem2reg.cpp" "CMakeFiles/pcc.dir/passes/mem2reg.cpp.o" "gcc" "CMakeFiles/pcc.dir/passes/mem2reg.cpp.o.d"
+  "/root/repo/preprocess.cpp" "CMakeFiles/pcc.dir/preprocess.cpp.o" "gcc" "CMakeFiles/pcc.dir/preprocess.cpp.o.d"
+  "/root/repo/scan.cpp" "CMakeFiles/pcc.dir/scan.cpp.o" "gcc" "CMakeFiles/pcc.dir/scan.cpp.o.d"
+  "/root/repo/source.cpp" "CMakeFiles/pcc.dir/source.cpp.o" "gcc" "CMakeFiles/pcc.dir/source.cpp.o.d"
+  "/root/repo/token_cache.cpp" "CMakeFiles/pcc.dir/token_cache.cpp.o" "gcc" "CMakeFiles/pcc.dir/token_cache.cpp.o.d"
+  "/root/repo/tokenize.cpp" "CMakeFiles/pcc.dir/tokenize.cpp.o" "gcc" "CMakeFiles/pcc.dir/tokenize.cpp.o.d"
+  "/root/repo/type.cpp" "CMakeFiles/pcc.dir/type.cpp.o" "gcc" "CMakeFiles/pcc.dir/type.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
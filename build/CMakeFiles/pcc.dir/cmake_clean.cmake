@@ -0,0 +1,55 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/pcc.dir/codegen.cpp.o"
+  "CMakeFiles/pcc.dir/codegen.cpp.o.d"
+  "CMakeFiles/pcc.dir/gen_ir.cpp.o"
+  "CMakeFiles/pcc.dir/gen_ir.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/BasicBlock.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/BasicBlock.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/Constant.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/Constant.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/Function.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/Function.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/GlobalObject.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/GlobalObject.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/GlobalVariable.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/GlobalVariable.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/IRContext.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/IRContext.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/IRPrinter.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/IRPrinter.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/Instruction.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/Instruction.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/Module.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/Module.cpp.o.d"
+  "CMakeFiles/pcc.dir/ir_core/Value.cpp.o"
+  "CMakeFiles/pcc.dir/ir_core/Value.cpp.o.d"
+  "CMakeFiles/pcc.dir/main.cpp.o"
+  "CMakeFiles/pcc.dir/main.cpp.o.d"
+  "CMakeFiles/pcc.dir/parse.cpp.o"
+  "CMakeFiles/pcc.dir/parse.cpp.o.d"
+  "CMakeFiles/pcc.dir/passes/dce.cpp.o"
+  "CMakeFiles/pcc.dir/passes/dce.cpp.o.d"
+  "CMakeFiles/pcc.dir/passes/gvn.cpp.o"
+  "CMakeFiles/pcc.dir/passes/gvn.cpp.o.d"
+  "CMakeFiles/pcc.dir/passes/mem2reg.cpp.o"
+  "CMakeFiles/pcc.dir/passes/mem2reg.cpp.o.d"
+  "CMakeFiles/pcc.dir/preprocess.cpp.o"
+  "CMakeFiles/pcc.dir/preprocess.cpp.o.d"
+  "CMakeFiles/pcc.dir/scan.cpp.o"
+  "CMakeFiles/pcc.dir/scan.cpp.o.d"
+  "CMakeFiles/pcc.dir/source.cpp.o"
+  "CMakeFiles/pcc.dir/source.cpp.o.d"
+  "CMakeFiles/pcc.dir/token_cache.cpp.o"
+  "CMakeFiles/pcc.dir/token_cache.cpp.o.d"
+  "CMakeFiles/pcc.dir/tokenize.cpp.o"
+  "CMakeFiles/pcc.dir/tokenize.cpp.o.d"
+  "CMakeFiles/pcc.dir/type.cpp.o"
+  "CMakeFiles/pcc.dir/type.cpp.o.d"
+  "pcc"
+  "pcc.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pcc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,8 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(test "python" "run_test.py")
+set_tests_properties(test PROPERTIES  WORKING_DIRECTORY "/root/repo/test" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;35;add_test;/root/repo/CMakeLists.txt;0;")
@@ -4,6 +4,7 @@
 #include "tokenize.hpp"
 #include "parse.hpp"
 #include "type.hpp"
+#include "source.hpp"
 #include "utils/util.hpp"
 
 
@@ -16,6 +17,10 @@ static char *argreg32[] = {"%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d"};
 static char *argreg64[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
 static Obj *current_fn;
 
+// the stack depth at which the innermost ND_OP_ASSIGN being generated
+// keeps the address it assigns to
+static int op_assign_depth;
+
 static void gen_expr(Node *node);
 static void gen_stmt(Node *node);
 
@@ -29,6 +34,14 @@ static void  println(char *fmt, ...) {
 }
 
 
+// .loc file_number line_number
+static void emit_loc(Token *tok)
+{
+    SourceFile *file = find_source_file(tok->loc);
+    println(" .loc %d %d", file->file_no, get_line_no(file, tok->loc));
+}
+
+
 static int count()
 {
     static int i = 1;
@@ -75,6 +88,11 @@ static void gen_addr(Node *node)
         gen_addr(node->lhs);
         println("  add $%d, %%rax", node->member->offset);
         return;
+    case ND_OP_ASSIGN:
+        break;
+    case ND_OLD_VALUE:
+        // only ever loaded, by gen_expr()
+        unreachable();
     }
 
     error_tok(node->tok, "not an lvalue");
@@ -191,8 +209,7 @@ static void cast(Type *from, Type *to)
 
 static void gen_expr(Node *node)
 {
-    // .loc file_number line_number
-    println(" .loc 1 %d", node->tok->line_no);
+    emit_loc(node->tok);
 
     switch (node->kind)
     {
@@ -222,6 +239,20 @@ static void gen_expr(Node *node)
         gen_expr(node->rhs);
         store(node->ty);
         return;
+    case ND_OP_ASSIGN: {
+        gen_addr(node->lhs);
+        push();
+        int saved = op_assign_depth;
+        op_assign_depth = depth;
+        gen_expr(node->rhs);
+        op_assign_depth = saved;
+        store(node->ty);
+        return;
+    }
+    case ND_OLD_VALUE:
+        println("  mov %d(%%rsp), %%rax", (depth - op_assign_depth) * 8);
+        load(node->ty);
+        return;
     case ND_STMT_EXPR:
         for (Node *n = node->body; n; n = n->next)
             gen_stmt(n);
@@ -358,6 +389,10 @@ static void gen_expr(Node *node)
 
         println("  movzb %%al, %%rax");
         return;
+    case ND_OP_ASSIGN:
+    case ND_OLD_VALUE:
+        // generated before the operands are evaluated
+        unreachable();
     }
 
     error_tok(node->tok, "invalid expression");
@@ -365,8 +400,7 @@ static void gen_expr(Node *node)
 
 static void gen_stmt(Node *node)
 {
-    // .loc file_number line_number
-    println(" .loc 1 %d", node->tok->line_no);
+    emit_loc(node->tok);
 
     switch (node->kind)
     {
@@ -424,6 +458,10 @@ static void gen_stmt(Node *node)
     case ND_EXPR_STMT:
         gen_expr(node->lhs);
         return;
+    case ND_OP_ASSIGN:
+    case ND_OLD_VALUE:
+        // expressions are wrapped in ND_EXPR_STMT
+        unreachable();
     }
 
     error_tok(node->tok, "invalid statement");
@@ -14,6 +14,9 @@
 static std::unordered_map<Obj*, Value*> alloca_map;
 static std::set<BB*> ret_blocks;
 
+// the address assigned to by the innermost ND_OP_ASSIGN being generated
+static Value *op_assign_addr;
+
 
 static Value *gen_expr(Node *node, IRBuilder& builder);
 
@@ -50,6 +53,11 @@ static Value *gen_addr(Node *node, IRBuilder& builder) {
   case ND_COMMA: 
     gen_expr(node->lhs, builder);
     return gen_addr(node->rhs, builder);
+  case ND_OP_ASSIGN:
+    break;
+  case ND_OLD_VALUE:
+    // only ever loaded, by gen_expr()
+    unreachable();
   }
 
   error_tok(node->tok, "not an lvalue");
@@ -65,6 +73,11 @@ static Value *gen_binop(ValueKind kind, Node *node, IRBuilder& builder) {
 
 static void gen_stmt(Node *node, Function* function, IRBuilder& builder);
 
+// an empty block has no back() to look at
+static bool is_terminated(BB *bb) {
+  return !bb->empty() && bb->back().is_terminator();
+}
+
 static Value *gen_expr(Node *node, IRBuilder& builder) {
   switch (node->kind) {
   case ND_NUM:
@@ -150,6 +163,17 @@ static Value *gen_expr(Node *node, IRBuilder& builder) {
     builder.create_store(val, addr);
     return val;
   }
+  case ND_OP_ASSIGN: {
+    Value *addr = gen_addr(node->lhs, builder);
+    Value *saved = op_assign_addr;
+    op_assign_addr = addr;
+    Value *val = gen_expr(node->rhs, builder);
+    op_assign_addr = saved;
+    builder.create_store(val, addr);
+    return val;
+  }
+  case ND_OLD_VALUE:
+    return builder.create_load(op_assign_addr);
   case ND_ADD:
     return gen_binop(ValueKind::INST_ADD, node, builder);
   case ND_SUB:
@@ -202,14 +226,14 @@ static void gen_stmt(Node *node, Function* function, IRBuilder& builder) {
 
     gen_stmt(node->then, function, builder);
 
-    if (!builder.get_insert_block()->back().is_terminator())
+    if (!is_terminated(builder.get_insert_block()))
       builder.create_br(last);
 
 
     builder.set_insert_point(els);
     if (node->els)
       gen_stmt(node->els, function, builder);
-    if (!builder.get_insert_block()->back().is_terminator())
+    if (!is_terminated(builder.get_insert_block()))
       builder.create_br(last);
 
     builder.set_insert_point(last);
@@ -234,7 +258,7 @@ static void gen_stmt(Node *node, Function* function, IRBuilder& builder) {
     
     builder.set_insert_point(body);
     gen_stmt(node->then, function, builder);
-    if (!builder.get_insert_block()->back().is_terminator())
+    if (!is_terminated(builder.get_insert_block()))
       builder.create_br(inc);
 
     builder.set_insert_point(inc);
@@ -257,6 +281,10 @@ static void gen_stmt(Node *node, Function* function, IRBuilder& builder) {
     for (Node *n = node->body; n; n = n->next)
         gen_stmt(n, function, builder);
     return;
+  case ND_OP_ASSIGN:
+  case ND_OLD_VALUE:
+    // expressions are wrapped in ND_EXPR_STMT
+    unreachable();
   }
 
   error_tok(node->tok, "invalid statement");
@@ -6,6 +6,7 @@
 BB::BB(Function *parent, BB* before): 
     Value(ty_void, ValueKind::BB), parent(parent) 
 {
+    slot = parent->new_block_slot();
     if (!before) 
         parent->get_bb_list().push_back(this);
     else
@@ -13,6 +14,12 @@ BB::BB(Function *parent, BB* before):
 }
 
 
+BB* BB::create(Function* parent, BB* before)
+{
+    return new (parent->get_allocator()) BB(parent, before);
+}
+
+
 BB::~BB()
 {
     drop_all_references();
@@ -49,7 +56,8 @@ iterator_range<BrInst::const_succ_iterator> BB::successors() const
 
 BBParam* BB::insert_param(Type* ty) 
 {
-    BBParam* param = new BBParam(ty, this, params.size());
+    BBParam* param = new (parent->get_allocator()) BBParam(ty, this, params.size());
+    param->slot = parent->new_value_slot();
     params.push_back(param);
     return param;
 }
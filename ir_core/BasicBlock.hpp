@@ -6,6 +6,7 @@
 #include "utils/ilist.hpp"
 #include "Instruction.hpp"
 #include "BasicBlockParam.hpp"
+#include "GraphTraits.hpp"
 
 
 class Function;
@@ -22,7 +23,7 @@ class Function;
  * parameters passed to this basic block.
  * 
  */
-class BB: public Value, public ilist_node<BB>
+class BB: public Value, public ilist_node<BB>, public SlabObject
 {
     friend class Inst;
     friend class ilist<BB>;
@@ -82,6 +83,7 @@ private:
     inst_list insts;
     param_list params;
     Function* parent;
+    mutable VisitMark visit_mark;
 
 private:
     BB() = delete;
@@ -102,9 +104,7 @@ public:
      *               the basic block is added at the end.
      * @return A pointer to the newly created basic block.
      */
-    static BB* create(Function* parent, BB* before = nullptr) {
-        return new BB(parent, before);
-    }
+    static BB* create(Function* parent, BB* before = nullptr);
 
     /**
      * @brief Gets the parent function of this basic block.
@@ -114,6 +114,13 @@ public:
     Function* get_parent() noexcept { return parent; }
     Function* get_parent() const noexcept { return parent; }
 
+    /**
+     * @brief Gets the mark graph traversals leave on this basic block.
+     * 
+     * @return A reference to the mark.
+     */
+    VisitMark& get_visit_mark() const noexcept { return visit_mark; }
+
     // Iterator functions for the list of instructions in this basic block.
     iterator begin() noexcept { return insts.begin(); }
     iterator end() noexcept { return insts.end(); }
@@ -177,6 +184,13 @@ public:
      */
     size_type size() const noexcept { return insts.size(); }
 
+    /**
+     * @brief Checks if this basic block has no instructions.
+     * 
+     * @return true if the basic block is empty, false otherwise.
+     */
+    bool empty() const noexcept { return insts.empty(); }
+
     pred_iterator pred_begin() noexcept {
         return pred_iterator(user_begin());
     }
@@ -194,7 +208,7 @@ public:
     }
 
     /// @brief Gets the number of predecessors
-    auto get_pred_num() const noexcept { return users.size(); }
+    auto get_pred_num() const noexcept { return use_count; }
 
     /**
      * @brief Returns an \c iterator_range over the list of predecessor basic blocks of this basic block.
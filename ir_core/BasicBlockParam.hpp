@@ -1,6 +1,7 @@
 #ifndef PCC_IR_CORE_BASICBLOCKPARAM_H
 #define PCC_IR_CORE_BASICBLOCKPARAM_H
 
+#include "utils/slab.hpp"
 #include "Value.hpp"
 
 
@@ -12,7 +13,7 @@
  * parameters of basic blocks. It keeps a reference to its parent basic block 
  * and maintains its position within the parameter list of the basic block.
  */
-class BBParam: public Value
+class BBParam: public Value, public SlabObject
 {
     friend class BB;
 
@@ -3,6 +3,7 @@
 
 #include "BasicBlock.hpp"
 #include "POTraversal.hpp"
+#include "SlotMap.hpp"
 #include "iterator/to_address.hpp"
 
 
@@ -84,7 +85,7 @@ template<typename NodeT, bool Post>
 class DominatorTreeBase
 {
 private:
-    std::unordered_map<NodeT*, DomTreeNodeBase<NodeT>*> doms;
+    SlotMap<NodeT, DomTreeNodeBase<NodeT>*> doms;
     DomTreeNodeBase<NodeT>* entry;
     static constexpr bool IsPostDominator = Post;
 
@@ -139,12 +140,7 @@ template<typename NodeT, bool Post>
 DomTreeNodeBase<NodeT>* 
 DominatorTreeBase<NodeT, Post>::get_node(const NodeT* block) const noexcept 
 { 
-    auto iter = doms.find(const_cast<NodeT*>(block));
-    if (iter != doms.end()) {
-        return iter->second;
-    }
-
-    return nullptr;
+    return doms.lookup(block);
 }
 
 
@@ -168,8 +164,8 @@ DominatorTreeBase<NodeT, Post>::intersect(DomTreeNodeBase<NodeT>* lhs, DomTreeNo
 template<typename NodeT, bool Post>
 DominatorTreeBase<NodeT, Post>::~DominatorTreeBase()
 {
-    for (auto iter = doms.begin(); iter != doms.end(); ++iter) {
-        delete iter->second;
+    for (DomTreeNodeBase<NodeT>* node: doms) {
+        delete node;
     }
 }
 
@@ -181,44 +177,50 @@ void DominatorTreeBase<NodeT, Post>::recalculate(parent_ptr func)
                     InverseGraphTraits<parent>, 
                     GraphTraits<parent>>;
 
-    int i = 0;
+    // nodes are found by their post-order number while the tree is built
+    for (DomTreeNodeBase<NodeT>* node: doms) {
+        delete node;
+    }
+    doms.reset(func);
+
     POTraversal<parent, GT> traversal(func);
-    for (auto iter = traversal.begin(); iter != traversal.end(); ++iter) {
-        doms[to_address(iter)] = new DomTreeNodeBase<NodeT>(i, to_address(iter));
-        ++i;
+    std::vector<DomTreeNodeBase<NodeT>*> nodes(traversal.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i] = new DomTreeNodeBase<NodeT>(i, traversal[i]);
+        doms[traversal[i]] = nodes[i];
     }
 
-    entry = doms[GT::get_entry_node(func)];
+    entry = nodes.back();
     entry->idom = entry;
 
     bool changed = true;
     while (changed)
     {
         changed = false;
-        for (auto bb = std::next(traversal.rbegin()); bb != traversal.rend(); ++bb) 
+        // in reverse post-order, after the entry
+        for (std::size_t i = nodes.size() - 1; i-- > 0;) 
         {
+            NodeT* bb = nodes[i]->block;
             DomTreeNodeBase<NodeT>* new_idom = nullptr;
-            bool first = true;
-            for (auto&& pred = GT::parent_begin(to_address(bb)); pred != GT::parent_end(to_address(bb)); ++pred) {
-                if (doms[to_address(pred)]->idom) {
-                    if (first) {
-                        new_idom = doms[to_address(pred)];
-                        first = false;
-                    }
-                    else
-                        new_idom = intersect(new_idom, doms[to_address(pred)]);
-                }
+            for (auto&& pred = GT::parent_begin(bb); pred != GT::parent_end(bb); ++pred) {
+                int num = traversal.po_number(to_address(pred));
+                if (num < 0 || !nodes[num]->idom)
+                    continue;
+
+                if (!new_idom)
+                    new_idom = nodes[num];
+                else
+                    new_idom = intersect(new_idom, nodes[num]);
             }
 
-            if (new_idom != doms[to_address(bb)]->idom) {
-                doms[to_address(bb)]->idom = new_idom;
+            if (new_idom != nodes[i]->idom) {
+                nodes[i]->idom = new_idom;
                 changed = true;
             }
         }       
     }
 
-    for (auto iter = doms.begin(); iter != doms.end(); ++iter) {
-        DomTreeNodeBase<NodeT>* node = iter->second;
+    for (DomTreeNodeBase<NodeT>* node: nodes) {
         if (node != entry)
             node->idom->children.push_back(node);
     }
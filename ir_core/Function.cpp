@@ -13,8 +13,28 @@ Function::Function(Type* ty, const std::string& name, Module* parent):
 void Function::build_params()
 {
     Type* func_ty = get_value_type();
-    for (Type* ty = func_ty->params; ty; ty = ty->next)
-        params.push_back(new FunctionParam(ty, this));
+    for (int i = 0; i < func_ty->num_params; ++i) {
+        params.push_back(new FunctionParam(func_ty->params[i], this));
+        params.back()->slot = new_value_slot();
+    }
+}
+
+
+void Function::renumber()
+{
+    value_slots = 0;
+    block_slots = 0;
+
+    for (FunctionParam* param: params)
+        param->slot = new_value_slot();
+
+    for (BB& bb: bbs) {
+        bb.slot = new_block_slot();
+        for (BBParam& param: bb.get_params())
+            param.slot = new_value_slot();
+        for (Inst& inst: bb)
+            inst.slot = new_value_slot();
+    }
 }
 
 Function::~Function()
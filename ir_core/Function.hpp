@@ -19,6 +19,7 @@
 class Function: public GlobalObject, public ilist_node<Function>
 {
     friend class BB;
+    friend class Inst;
     friend class ilist<Function>;
 
 public:
@@ -31,8 +32,12 @@ public:
     using size_type = bb_list::size_type; ///< Size type for basic block list.
 
 private:
+    SlabAllocator allocator; ///< Holds the blocks, parameters and instructions; outlives \c bbs.
     bb_list bbs; ///< List of basic blocks within the function.
     param_list params; ///< List of function parameters.
+    mutable unsigned visit_epoch = 0; ///< The epoch of the latest traversal.
+    unsigned value_slots = 0; ///< The number of value slots handed out.
+    unsigned block_slots = 0; ///< The number of block slots handed out.
 
 private:
     /**
@@ -52,6 +57,9 @@ private:
 
     void build_params();
 
+    unsigned new_value_slot() noexcept { return value_slots++; }
+    unsigned new_block_slot() noexcept { return block_slots++; }
+
 public:
     /**
      * @brief Creates a new \c Function.
@@ -66,6 +74,14 @@ public:
         return new Function(ty, name, parent);
     }
 
+    /**
+     * @brief Returns the allocator the basic blocks, their parameters and
+     *        the instructions of the function are made in.
+     * 
+     * @return The allocator of the function.
+     */
+    SlabAllocator& get_allocator() noexcept { return allocator; }
+
     /**
      * @brief Returns an iterator pointing to the first basic block in the function.
      * 
@@ -94,6 +110,50 @@ public:
      */
     const_iterator end() const noexcept { return bbs.end(); }
 
+    /**
+     * @brief Starts a traversal of the basic blocks of the function.
+     * 
+     * Blocks whose \c VisitMark carries the returned epoch have been
+     * visited by the new traversal. A function is traversed by one
+     * thread at a time.
+     * 
+     * @return The epoch of the new traversal.
+     */
+    unsigned new_visit_epoch() const noexcept {
+        if (++visit_epoch == 0) {
+            for (const BB& bb: bbs)
+                bb.get_visit_mark() = VisitMark();
+            visit_epoch = 1;
+        }
+        return visit_epoch;
+    }
+
+    /**
+     * @brief Returns the number of value slots in the function.
+     * 
+     * Every parameter, block parameter and instruction of the function has
+     * a slot below this number. Erased values leave their slots unused
+     * until the next renumber().
+     * 
+     * @return The number of value slots.
+     */
+    unsigned value_slot_count() const noexcept { return value_slots; }
+
+    /**
+     * @brief Returns the number of block slots in the function.
+     * 
+     * @return The number of block slots.
+     */
+    unsigned block_slot_count() const noexcept { return block_slots; }
+
+    /**
+     * @brief Numbers the values and basic blocks of the function densely again.
+     * 
+     * Slots follow the order of the function. Side tables built before
+     * renumbering are invalidated.
+     */
+    void renumber();
+
     /**
      * @brief Returns the number of basic blocks in the function.
      * 
@@ -237,6 +297,9 @@ struct GraphTraits<Function>
     static node_iterator nodes_end(Function *f) { return f->end(); }
 
     static Function::size_type size(Function *f) { return f->size(); }
+
+    static unsigned new_epoch(Function *f) { return f->new_visit_epoch(); }
+    static VisitMark& visit_mark(node_type n) { return n->get_visit_mark(); }
 };
 
 
@@ -259,6 +322,9 @@ struct GraphTraits<const Function> {
     static node_iterator nodes_end(const Function *f) { return f->end(); }
 
     static Function::size_type size(const Function *f) { return f->size(); }
+
+    static unsigned new_epoch(const Function *f) { return f->new_visit_epoch(); }
+    static VisitMark& visit_mark(node_type n) { return n->get_visit_mark(); }
 };
 
 
@@ -283,6 +349,9 @@ struct InverseGraphTraits<Function>
     static node_iterator nodes_end(Function *f) { return std::make_reverse_iterator(f->begin()); }
 
     static Function::size_type size(Function *f) { return f->size(); }
+
+    static unsigned new_epoch(Function *f) { return f->new_visit_epoch(); }
+    static VisitMark& visit_mark(node_type n) { return n->get_visit_mark(); }
 };
 
 
@@ -312,6 +381,9 @@ struct InverseGraphTraits<const Function>
     }
 
     static Function::size_type size(const Function *f) { return f->size(); }
+
+    static unsigned new_epoch(const Function *f) { return f->new_visit_epoch(); }
+    static VisitMark& visit_mark(node_type n) { return n->get_visit_mark(); }
 };
 
 
@@ -8,20 +8,15 @@ IRContext& GlobalObject::get_context() const
 }
 
 
-std::string GlobalObject::get_name() const
+const std::string& GlobalObject::get_name() const
 {
-    return get_context().get_name(this);
+    return get_context().get_name(get_name_id());
 }
 
 
 void GlobalObject::set_name(const std::string& name)
 {
-    return get_context().set_name(this, name);
-}
-
-
-GlobalObject::~GlobalObject() {
-    get_context().delete_name(this);
+    set_name_id(get_context().intern_name(name));
 }
 
 
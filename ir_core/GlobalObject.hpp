@@ -40,8 +40,6 @@ protected:
     GlobalObject(const GlobalObject&) = delete;
     GlobalObject& operator=(const GlobalObject&) = delete;
 
-    ~GlobalObject();
-
 public:
     /**
      * @brief Returns the context in which this global object is defined.
@@ -64,7 +62,7 @@ public:
      * 
      * @return The name of the global object.
      */
-    std::string get_name() const;
+    const std::string& get_name() const;
 
     /**
      * @brief Sets the name of the global object.
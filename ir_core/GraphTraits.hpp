@@ -3,6 +3,20 @@
 
 
 
+/**
+ * @brief The mark a graph traversal leaves on a node it visits.
+ * 
+ * A traversal takes a new epoch from the graph when it starts, so a node
+ * whose epoch differs has not been visited by it yet, and the marks left
+ * by earlier traversals never need to be cleared.
+ */
+struct VisitMark
+{
+    unsigned epoch = 0; ///< The epoch of the traversal that visited the node last.
+    int num = -1; ///< The number that traversal gave the node.
+};
+
+
 /**
  * @brief A primary template for graph traits of a graph type.
  * 
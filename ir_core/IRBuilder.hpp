@@ -20,6 +20,14 @@ private:
     BB* parent;
     BB::iterator insert_point;
 
+    /// The allocator of the function instructions are inserted into.
+    SlabAllocator& slab() const { return parent->get_parent()->get_allocator(); }
+
+    /// The instruction new instructions go before, or null at the end of the block.
+    Inst* before() const {
+        return insert_point == parent->end() ? nullptr : to_address(insert_point);
+    }
+
 public:
     IRBuilder() = delete;
 
@@ -88,7 +96,7 @@ public:
      * @return Pointer to the created \c UnaryInst object
      */
     UnaryInst* create_unary(ValueKind kind, Value* src) {
-        return new UnaryInst(kind, src, parent, to_address(insert_point));
+        return new (slab()) UnaryInst(kind, src, parent, before());
     }
 
     /**
@@ -99,7 +107,7 @@ public:
      * @return Pointer to the created \c BinaryInst object
      */
     BinaryInst* create_binary(ValueKind kind, Value* lhs, Value* rhs) {
-        return new BinaryInst(kind, lhs, rhs, parent, to_address(insert_point));
+        return new (slab()) BinaryInst(kind, lhs, rhs, parent, before());
     }
 
     /**
@@ -108,7 +116,7 @@ public:
      * @return Pointer to the created \c LoadInst object
      */
     LoadInst* create_load(Value* src) {
-        return new LoadInst(src, parent, to_address(insert_point));
+        return new (slab()) LoadInst(src, parent, before());
     }
 
     /**
@@ -118,7 +126,7 @@ public:
      * @return Pointer to the created \c CastInst object
      */
     CastInst* create_cast(Type* ty, Value* src) {
-        return new CastInst(ty, src, parent, to_address(insert_point));
+        return new (slab()) CastInst(ty, src, parent, before());
     }
 
     /**
@@ -128,7 +136,7 @@ public:
      * @return Pointer to the created \c StoreInst object
      */
     StoreInst* create_store(Value* src, Value* dst) {
-        return new StoreInst(src, dst, parent, to_address(insert_point));
+        return new (slab()) StoreInst(src, dst, parent, before());
     }
 
     /**
@@ -139,7 +147,7 @@ public:
      * @return Pointer to the created \c CmpInst object
      */
     CmpInst* create_cmp(ValueKind kind, Value* lhs, Value* rhs) {
-        return new CmpInst(kind, lhs, rhs, parent, to_address(insert_point));
+        return new (slab()) CmpInst(kind, lhs, rhs, parent, before());
     }
 
     /**
@@ -148,7 +156,7 @@ public:
      * @return Pointer to the created \c RetInst object
      */
     RetInst* create_ret(Value* ret) {
-        return new RetInst(ret, parent, to_address(insert_point));
+        return new (slab()) RetInst(ret, parent, before());
     }
 
     /**
@@ -157,7 +165,7 @@ public:
      * @return Pointer to the created \c AllocaInst object
      */
     AllocaInst* create_alloca(Type* ty) {
-        return new AllocaInst(ty, parent, to_address(insert_point));
+        return new (slab()) AllocaInst(ty, parent, before());
     }
 
     /**
@@ -167,7 +175,7 @@ public:
      * @return Pointer to the created \c BrInst object
      */
     BrInst* create_br(BB* dst, const std::vector<Value*>& args = {}) {
-        return new BrInst(dst, parent, to_address(insert_point), args);
+        return new (slab()) BrInst(dst, parent, before(), args);
     }
 
     /**
@@ -183,7 +191,7 @@ public:
         const std::vector<Value*>& then_args = {}, 
         const std::vector<Value*>& else_args = {}) 
     {
-        return new BrInst(cond, then_, else_, parent, to_address(insert_point), then_args, else_args);
+        return new (slab()) BrInst(cond, then_, else_, parent, before(), then_args, else_args);
     }
 
 
@@ -194,7 +202,7 @@ public:
      * @return Pointer to the created \c CallInst object
      */
     CallInst* create_call(Function* callee, const std::vector<Value*>& args) {
-        return new CallInst(callee, args, parent, to_address(insert_point));
+        return new (slab()) CallInst(callee, args, parent, before());
     }
     
 };
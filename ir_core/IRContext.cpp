@@ -3,23 +3,50 @@
 
 IRContext::~IRContext()
 {
+    // a module removes itself from the set as it's deleted
     while (!modules.empty())
         delete *modules.begin();
-    
-    while (!int_constants.empty()) {
-        delete int_constants.begin()->second;
-        int_constants.erase(int_constants.begin());
+
+    for (auto&& shard: constant_shards) {
+        for (auto&& [val, constant]: shard.constants)
+            delete constant;
     }
 }
 
-ConstantInt* IRContext::get_constant(std::int64_t val) {
-    auto iter = int_constants.find(val);
-    if (iter != int_constants.end()) {
-        return iter->second;
+unsigned IRContext::intern_name(const std::string& name)
+{
+    if (name.empty())
+        return 0;
+
+    {
+        std::shared_lock<std::shared_mutex> guard(name_lock);
+        auto iter = name_ids.find(name);
+        if (iter != name_ids.end())
+            return iter->second;
     }
 
-    Type* ty = val == (std::int32_t)val ? ty_int : ty_long;
-    int_constants[val] = new ConstantInt(ty, val);
-    return int_constants[val];
+    // another thread may have added the name since the lookup
+    std::lock_guard<std::shared_mutex> guard(name_lock);
+    auto iter = name_ids.find(name);
+    if (iter != name_ids.end())
+        return iter->second;
+
+    unsigned id = names.size();
+    names.push_back(name);
+    name_ids.emplace(names.back(), id);
+    return id;
+}
+
+
+ConstantInt* IRContext::get_constant(std::int64_t val) {
+    ConstantShard& shard = constant_shards[std::hash<std::int64_t>{}(val) % num_constant_shards];
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    ConstantInt*& constant = shard.constants[val];
+    if (!constant) {
+        Type* ty = val == (std::int32_t)val ? ty_int : ty_long;
+        constant = new ConstantInt(ty, val);
+    }
+    return constant;
 }
 
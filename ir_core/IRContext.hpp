@@ -2,8 +2,12 @@
 #define PCC_IR_CORE_IRCONTEXT_H
 
 
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include "Module.hpp"
 
@@ -14,6 +18,10 @@
  * @brief Represents the context for the Intermediate Representation (IR).
  * 
  * The IRContext manages modules, constant integers, and value names within the IR.
+ *
+ * All of them may be reached from several threads at once, so passes can
+ * run on different functions of a module concurrently. Constants are kept
+ * in shards with a lock each; names are interned under a reader-writer lock.
  */
 class IRContext
 {
@@ -22,9 +30,20 @@ class IRContext
     friend class Module;
 
 private:
+    struct ConstantShard {
+        std::mutex lock;
+        std::unordered_map<std::int64_t, ConstantInt*> constants;
+    };
+
+    static constexpr unsigned num_constant_shards = 16;
+
+    std::mutex module_lock;
     std::unordered_set<Module*> modules;
-    std::unordered_map<std::int64_t, ConstantInt*> int_constants;
-    std::unordered_map<const Value*, std::string> value_names;
+    ConstantShard constant_shards[num_constant_shards];
+
+    mutable std::shared_mutex name_lock;
+    std::deque<std::string> names; ///< Interned names, indexed by id; 0 is the empty name.
+    std::unordered_map<std::string_view, unsigned> name_ids; ///< Keys view \c names.
 
     /**
      * @brief Retrieves the constant integer with the given value if it exists; otherwise, creates a new one.
@@ -34,28 +53,38 @@ private:
      */
     ConstantInt* get_constant(std::int64_t val);
 
-    std::string get_name(const Value* val) {
-        return value_names[val];
-    }
-
-    void set_name(const Value *val, const std::string& name) {
-        value_names[val] = name;
-    }
+    /**
+     * @brief Returns the id of \p name, adding it to the pool if it's new.
+     * 
+     * @param name The name to intern.
+     * @return The id of the name; 0 for the empty name.
+     */
+    unsigned intern_name(const std::string& name);
 
-    void delete_name(const Value* val) {
-        value_names.erase(val);
+    /**
+     * @brief Returns the name with the given id.
+     * 
+     * @param id An id returned by \c intern_name().
+     * @return The name.
+     */
+    const std::string& get_name(unsigned id) const {
+        // the deque may grow meanwhile; its elements stay where they are
+        std::shared_lock<std::shared_mutex> guard(name_lock);
+        return names[id];
     }
 
     void add_module(Module* m) {
+        std::lock_guard<std::mutex> guard(module_lock);
         modules.insert(m);
     }
 
     void remove_module(Module* m) {
+        std::lock_guard<std::mutex> guard(module_lock);
         modules.erase(m);
     }
 
 public:
-    IRContext() = default;
+    IRContext(): names(1) {}
     IRContext(const IRContext&) = delete;
     IRContext& operator=(const IRContext&) = delete;
     ~IRContext();
@@ -81,6 +81,21 @@ std::string IRPrinter::ty_to_str(Type *ty)
     unreachable();
 }
 
+void IRPrinter::reset_numbers(const Function *func)
+{
+    val_to_num.reset(func);
+    bb_to_num.reset(func);
+    next_num = 0;
+}
+
+int IRPrinter::number_of(const Value *v)
+{
+    int &num = isa<BB>(v) ? bb_to_num[cast<const BB>(v)] : val_to_num[v];
+    if (num < 0)
+        num = next_num++;
+    return num;
+}
+
 std::string IRPrinter::val_to_str(const Value *v)
 {
     if (const ConstantInt* const_int = dyn_cast<const ConstantInt>(v)) {
@@ -91,15 +106,11 @@ std::string IRPrinter::val_to_str(const Value *v)
         return ty_to_str(g->get_type()) + " @" + g->get_name();
     }
 
-    if (val_to_num.find(v) == val_to_num.end()) {
-        val_to_num[v] = val_to_num.size();
-    }
-
     if (isa<BB>(v)) {
-        return "%" + std::to_string(val_to_num[v]);
+        return "%" + std::to_string(number_of(v));
     }
 
-    return ty_to_str(v->get_type()) + " %" + std::to_string(val_to_num[v]);
+    return ty_to_str(v->get_type()) + " %" + std::to_string(number_of(v));
 }
 
 std::string IRPrinter::inst_to_str(const Inst *inst)
@@ -144,7 +155,7 @@ std::string IRPrinter::inst_to_str(const Inst *inst)
     else {
         std::string rhs = op_to_str(inst->get_kind()) + " ";
 
-        for (int i = 0; i < inst->get_num_operands(); ++i) {
+        for (Inst::op_size_type i = 0; i < inst->get_num_operands(); ++i) {
             rhs += val_to_str(inst->get_operand(i));
             if (i + 1 < inst->get_num_operands()) {
                 rhs += ", ";
@@ -203,7 +214,7 @@ void IRPrinter::print(const BB *bb, std::ostream &os, bool debug)
 
 void IRPrinter::print(const Function *func, std::ostream &os, bool debug)
 {
-    val_to_num.clear();
+    reset_numbers(func);
 
     std::string decl = "define " + ty_to_str(func->get_return_type()) + " @" + func->get_name() + "(";
 
@@ -241,8 +252,9 @@ void IRPrinter::print(const Module *m, std::ostream &os, bool debug)
 
 void IRPrinter::gen_dot_cfg(const Function* func, std::ostream &os, bool debug)
 {
-    val_to_num.clear();
-    std::unordered_map<const BB*, int> bb_to_num;
+    reset_numbers(func);
+    BBMap<int> dot_ids(func, -1);
+    int next_id = 0;
 
     std::string decl = "define " + ty_to_str(func->get_return_type()) + " @" + func->get_name() + "(";
     for (auto iter = func->param_begin(); iter != func->param_end(); ++iter) {
@@ -256,8 +268,8 @@ void IRPrinter::gen_dot_cfg(const Function* func, std::ostream &os, bool debug)
     os << "digraph g\n{\n";
     for (auto bb = func->begin(); bb != func->end(); ++bb)
     {
-        bb_to_num[to_address(bb)] = bb_to_num.size();
-        os << bb_to_num[to_address(bb)] << " [label=\"";
+        dot_ids[to_address(bb)] = next_id++;
+        os << dot_ids.lookup(to_address(bb)) << " [label=\"";
 
         if (bb == func->begin()) {
             os << decl;
@@ -270,7 +282,7 @@ void IRPrinter::gen_dot_cfg(const Function* func, std::ostream &os, bool debug)
     for (auto bb = func->begin(); bb != func->end(); ++bb)
     {
         for (auto&& successor: bb->successors())
-            os << bb_to_num[to_address(bb)] << " -> " << bb_to_num[&successor] << '\n';
+            os << dot_ids.lookup(to_address(bb)) << " -> " << dot_ids.lookup(&successor) << '\n';
     }
 
     os << "}";
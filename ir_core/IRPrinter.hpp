@@ -3,7 +3,7 @@
 
 #include <iostream>
 #include <string>
-#include <unordered_map>
+#include "SlotMap.hpp"
 
 enum class ValueKind;
 class Type;
@@ -73,7 +73,12 @@ public:
     void gen_dot_cfg(const Function* func, const std::string& name, bool debug);
 
 private:
-    std::unordered_map<const Value*, int> val_to_num;
+    ValueMap<int> val_to_num{-1};
+    BBMap<int> bb_to_num{-1};
+    int next_num = 0; ///< Values and blocks are numbered together, in the order they are printed.
+
+    void reset_numbers(const Function *func);
+    int number_of(const Value *v);
 
     std::string op_to_str(ValueKind kind);
     std::string ty_to_str(Type *ty);
@@ -7,14 +7,35 @@ Inst::Inst(Type* ty, ValueKind kind, BB* parent, Inst* before):
     User(ty, kind), parent(parent) 
 {
     if (parent)
+        link(before);
+}
+
+
+Inst::Inst(Type* ty, ValueKind kind, Use* slots, op_size_type n, BB* parent, Inst* before): 
+    User(ty, kind, slots, n), parent(parent) 
+{
+    if (parent)
+        link(before);
+}
+
+
+void Inst::link(Inst* before)
+{
+    set_slot(parent->get_parent()->new_value_slot());
+    if (!before)
+        parent->get_inst_list().push_back(this);
+    else
         parent->get_inst_list().insert(before, this);
 }
 
 
 Inst* Inst::clone() const
 {
-    Inst* inst = new Inst(get_type(), get_kind(), nullptr, nullptr);
-    for (int i = 0; i < this->get_num_operands(); ++i) {
+    Function* fn = parent->get_parent();
+    Inst* inst = new (fn->get_allocator()) Inst(get_type(), get_kind(), nullptr, nullptr);
+    inst->set_slot(fn->new_value_slot());
+    inst->reserve_operands(get_num_operands());
+    for (op_size_type i = 0; i < this->get_num_operands(); ++i) {
         inst->add_operand(this->get_operand(i));
     }
     
@@ -77,14 +98,14 @@ ilist<Inst>::iterator Inst::move_after(Inst *pos)
 
 
 UnaryInst::UnaryInst(ValueKind kind, Value* src, BB* parent, Inst* before): 
-    Inst(src->get_type(), kind, parent, before)
+    Inst(src->get_type(), kind, operands.slots, 1, parent, before)
 {
     add_operand(src);
 }
 
 
 BinaryInst::BinaryInst(ValueKind kind, Value* lhs, Value* rhs, BB* parent, Inst* before): 
-    Inst(lhs->get_type(), kind, parent, before)
+    Inst(lhs->get_type(), kind, operands.slots, 2, parent, before)
 {
     add_operand(lhs);
     add_operand(rhs);
@@ -92,14 +113,14 @@ BinaryInst::BinaryInst(ValueKind kind, Value* lhs, Value* rhs, BB* parent, Inst*
 
 
 RetInst::RetInst(Value* ret, BB* parent, Inst* before): 
-    Inst(ty_void, ValueKind::INST_RETURN, parent, before) 
+    Inst(ty_void, ValueKind::INST_RETURN, operands.slots, 1, parent, before) 
 {
     add_operand(ret);
 }
 
 
 StoreInst::StoreInst(Value* src, Value* dst, BB* parent, Inst* before): 
-    Inst(ty_void, ValueKind::INST_STORE, parent, before)
+    Inst(ty_void, ValueKind::INST_STORE, operands.slots, 2, parent, before)
 {
     add_operand(src);
     add_operand(dst);
@@ -111,6 +132,7 @@ BrInst::BrInst(BB* then_, BB* parent, Inst* before, const std::vector<Value*>& t
     Inst(ty_void, ValueKind::INST_BR, parent, before),
     else_args_offset(-1)
 {
+    reserve_operands(1 + then_args.size());
     add_operand(then_);
     for (auto &&arg : then_args)
         add_operand(arg);
@@ -123,6 +145,7 @@ BrInst::BrInst(Value* cond, BB* then_, BB* else_, BB* parent, Inst* before,
     Inst(ty_void, ValueKind::INST_BR, parent, before),
     else_args_offset(3 + then_args.size())
 {
+    reserve_operands(3 + then_args.size() + else_args.size());
     add_operand(cond);
     add_operand(then_);
     add_operand(else_);
@@ -296,6 +319,7 @@ BrInst::get_args(op_size_type i) const
 CallInst::CallInst(Function* callee, const std::vector<Value*>& args, BB* parent, Inst* before):
     Inst(callee->get_return_type(), ValueKind::INST_CALL, parent, before)
 {
+    reserve_operands(1 + args.size());
     add_operand(callee);
     for (auto &&arg : args)
         add_operand(arg);        
@@ -2,7 +2,9 @@
 #define PCC_IR_CORE_INSTRUCTION_H
 
 
+#include <vector>
 #include "utils/ilist.hpp"
+#include "utils/slab.hpp"
 #include "User.hpp"
 
 
@@ -19,7 +21,7 @@ class Function;
  *
  * @note Only \c IRBuilder should create instances of this class.
  */
-class Inst: public User, public ilist_node<Inst>
+class Inst: public User, public ilist_node<Inst>, public SlabObject
 {
     friend class IRBuilder;
     friend class ilist<Inst>;
@@ -27,6 +29,9 @@ class Inst: public User, public ilist_node<Inst>
 private:
     BB* parent;
 
+    /// Gives a new instruction its slot and inserts it into \c parent before \p before, or at the end.
+    void link(Inst* before);
+
 protected:
     Inst() = delete;
 
@@ -36,9 +41,23 @@ protected:
      * @param ty The type of the value this \c Inst represents.
      * @param kind The kind of value this \c Inst represents.
      * @param parent The basic block this instruction is a part of.
-     * @param before The instruction before which this instruction should be inserted.
+     * @param before The instruction before which this instruction should be inserted,
+     *               or null to append it to \p parent.
      */
     Inst(Type* ty, ValueKind kind, BB* parent, Inst* before);
+
+    /**
+     * @brief Constructor used to initialize an \c Inst object with a fixed number of operands.
+     * 
+     * @param ty The type of the value this \c Inst represents.
+     * @param kind The kind of value this \c Inst represents.
+     * @param slots The operand slots, held by the subclass.
+     * @param n The number of operand slots.
+     * @param parent The basic block this instruction is a part of.
+     * @param before The instruction before which this instruction should be inserted,
+     *               or null to append it to \p parent.
+     */
+    Inst(Type* ty, ValueKind kind, Use* slots, op_size_type n, BB* parent, Inst* before);
     Inst(const Inst&) = delete;
     Inst& operator=(const Inst&) = delete;
 
@@ -136,6 +155,9 @@ public:
 class UnaryInst: public Inst
 {
     friend class IRBuilder;
+private:
+    Operands<1> operands;
+
 protected:
     /**
      * @brief Constructor used to initialize an \c UnaryInst object.
@@ -204,7 +226,9 @@ public:
 class BinaryInst: public Inst
 {
     friend class IRBuilder;
-    
+private:
+    Operands<2> operands;
+
 protected:
     BinaryInst(ValueKind kind, Value* lhs, Value* rhs, BB* parent, Inst* before);
 
@@ -240,6 +264,8 @@ class RetInst: public Inst
 {
     friend class IRBuilder;
 private:
+    Operands<1> operands;
+
     RetInst(Value* ret, BB* parent, Inst* before);
 
 public:
@@ -275,6 +301,8 @@ class StoreInst: public Inst
 {
     friend class IRBuilder;
 private:
+    Operands<2> operands;
+
     StoreInst(Value* src, Value* dst, BB* parent, Inst* before);
 
 public:
@@ -372,6 +400,15 @@ public:
      */
     bool is_conditional() const noexcept { return else_args_offset != -1; }
 
+    /**
+     * @brief Get the number of successors of this branch.
+     *
+     * Both successors of a conditional branch may be the same block.
+     *
+     * @return 2 if this branch is conditional, 1 otherwise.
+     */
+    op_size_type get_num_successors() const noexcept { return is_conditional() ? 2 : 1; }
+
     /**
      * @brief Get the condition of this branch.
      * 
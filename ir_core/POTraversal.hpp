@@ -2,6 +2,8 @@
 #define PCC_IR_CORE_POTRAVERSAL_H
 
 
+#include <utility>
+#include <vector>
 #include "Function.hpp"
 #include "GraphTraits.hpp"
 
@@ -10,6 +12,13 @@
  * @class POTraversal
  * @brief Class for Post Order Traversal over a graph.
  * 
+ * The depth first search runs on an explicit stack, so deep graphs don't
+ * exhaust the native one, and marks visited nodes through \c GT::visit_mark()
+ * with an epoch taken from \c GT::new_epoch() rather than keeping a set.
+ * Each node reached is numbered by its position in post-order. The numbers
+ * live in the nodes' marks, so they are valid until the graph is traversed
+ * again.
+ * 
  * @tparam Graph The type of the grapth to be traversed
  * @tparam GT The trait of the graph
  */
@@ -18,23 +27,47 @@ class POTraversal
 {
 public:
     using node_type = typename GT::node_type;
+    using size_type = typename std::vector<node_type>::size_type;
     using iterator = indirect_iterator<typename std::vector<node_type>::iterator>;
     using const_iterator = indirect_iterator<typename std::vector<node_type>::const_iterator>;
     using reverse_iterator = indirect_iterator<typename std::vector<node_type>::reverse_iterator>;
     using const_reverse_iterator = indirect_iterator<typename std::vector<node_type>::const_reverse_iterator>;
 
 private:
-    std::unordered_set<node_type> visited; ///< Set of visited nodes.
-    std::vector<node_type> nodes; ///< nodes in post-order.
+    using child_iterator = typename GT::child_iterator;
 
-    void dfs(node_type node) {
-        visited.insert(node);
-        for (auto&& succ = GT::child_begin(node); succ != GT::child_end(node); ++succ) {
-            if (visited.find(to_address(succ)) == visited.end())
-                dfs(to_address(succ));
+    std::vector<node_type> nodes; ///< nodes in post-order.
+    unsigned epoch; ///< The epoch the nodes visited are marked with.
+
+    void dfs(Graph* g) {
+        // a node with the next of its children to look at; the stack
+        // never holds more frames than the graph has nodes
+        std::vector<std::pair<node_type, child_iterator>> stack;
+        stack.reserve(GT::size(g));
+        nodes.reserve(GT::size(g));
+
+        auto visit = [&](node_type node) {
+            GT::visit_mark(node) = {epoch, -1};
+            stack.emplace_back(node, GT::child_begin(node));
+        };
+
+        visit(GT::get_entry_node(g));
+        while (!stack.empty()) {
+            node_type node = stack.back().first;
+            child_iterator& succ = stack.back().second;
+
+            if (succ != GT::child_end(node)) {
+                node_type child = to_address(succ);
+                ++succ;
+                if (GT::visit_mark(child).epoch != epoch)
+                    visit(child);
+                continue;
+            }
+
+            GT::visit_mark(node).num = nodes.size();
+            nodes.push_back(node);
+            stack.pop_back();
         }
-
-        nodes.push_back(node);
     }
 
 public:
@@ -43,12 +76,44 @@ public:
      * @param g The graph will be traversed.
      */
     explicit POTraversal(const Graph* g) {
-        dfs(GT::get_entry_node(const_cast<Graph*>(g)));
-        visited.clear();
+        Graph* graph = const_cast<Graph*>(g);
+        epoch = GT::new_epoch(graph);
+        dfs(graph);
     }
 
     ~POTraversal() = default;
 
+    /**
+     * @brief Returns the number of nodes reached from the entry node.
+     */
+    size_type size() const noexcept { return nodes.size(); }
+
+    /**
+     * @brief Returns the position of a node in post-order.
+     * @param node A node of the graph.
+     * @return The position, or -1 if the node wasn't reached.
+     */
+    int po_number(node_type node) const {
+        const VisitMark& mark = GT::visit_mark(node);
+        return mark.epoch == epoch ? mark.num : -1;
+    }
+
+    /**
+     * @brief Returns the position of a node in reverse post-order.
+     * @param node A node of the graph.
+     * @return The position, or -1 if the node wasn't reached.
+     */
+    int rpo_number(node_type node) const {
+        int num = po_number(node);
+        return num < 0 ? -1 : (int)nodes.size() - 1 - num;
+    }
+
+    /**
+     * @brief Returns the node at a position in post-order.
+     * @param num The position.
+     */
+    node_type operator[](size_type num) const { return nodes[num]; }
+
     iterator begin() { return make_indirect_iterator(nodes.begin()); }
     const_iterator begin() const { return make_indirect_iterator(nodes.begin()); }
 
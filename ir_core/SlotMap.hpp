@@ -0,0 +1,180 @@
+#ifndef PCC_IR_CORE_SLOTMAP_H
+#define PCC_IR_CORE_SLOTMAP_H
+
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "Function.hpp"
+
+
+/**
+ * @brief Returns the number of slots keys of type \p KeyT have in \p fn.
+ *
+ * @tparam KeyT \c BB for block slots, any other \c Value for value slots.
+ */
+template<typename KeyT>
+unsigned slot_count(const Function* fn) noexcept
+{
+    if constexpr (std::is_same_v<std::remove_const_t<KeyT>, BB>)
+        return fn->block_slot_count();
+    else
+        return fn->value_slot_count();
+}
+
+
+/**
+ * @class SlotMap
+ * @brief A side table for the values or basic blocks of a \c Function.
+ *
+ * Entries live in a vector indexed by the slot of their key, so a lookup
+ * is an array access. The table covers the slots the function had when
+ * it was reset, and grows when an entry is made for a newer key. Keys
+ * must belong to the function; \c lookup() also takes values outside it.
+ *
+ * @tparam KeyT \c BB for a table over basic blocks, \c Value for one over values.
+ * @tparam T The type of the entries.
+ */
+template<typename KeyT, typename T>
+class SlotMap
+{
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+private:
+    std::vector<T> entries;
+    T init; ///< The value of entries that were never set.
+
+public:
+    explicit SlotMap(const T& init = T()): init(init) {}
+
+    /**
+     * @brief Constructs a table over the slots of \p fn.
+     *
+     * @param fn The function whose values or blocks are the keys.
+     * @param init The value of entries that were never set.
+     */
+    explicit SlotMap(const Function* fn, const T& init = T()): init(init) {
+        reset(fn);
+    }
+
+    /**
+     * @brief Drops every entry and sizes the table for the slots of \p fn.
+     *
+     * @param fn The function whose values or blocks are the keys.
+     */
+    void reset(const Function* fn) {
+        entries.assign(slot_count<KeyT>(fn), init);
+    }
+
+    /**
+     * @brief Returns the entry for \p key, which must have a slot.
+     *
+     * @param key The key.
+     * @return A reference to the entry.
+     */
+    T& operator[](const KeyT* key) {
+        unsigned slot = key->get_slot();
+        assert(slot != Value::no_slot && "the key isn't in a function");
+        if (slot >= entries.size())
+            entries.resize(slot + 1, init);
+        return entries[slot];
+    }
+
+    /**
+     * @brief Returns the entry for \p key without making one.
+     *
+     * @param key The key, which may have no slot.
+     * @return The entry, or the initial value if there is none.
+     */
+    const T& lookup(const KeyT* key) const noexcept {
+        unsigned slot = key->get_slot();
+        return slot < entries.size() ? entries[slot] : init;
+    }
+
+    iterator begin() noexcept { return entries.begin(); }
+    iterator end() noexcept { return entries.end(); }
+    const_iterator begin() const noexcept { return entries.begin(); }
+    const_iterator end() const noexcept { return entries.end(); }
+};
+
+
+/**
+ * @class SlotSet
+ * @brief A bitset over the values or basic blocks of a \c Function.
+ *
+ * @tparam KeyT \c BB for a set of basic blocks, \c Value for a set of values.
+ */
+template<typename KeyT>
+class SlotSet
+{
+private:
+    std::vector<std::uint64_t> words;
+
+public:
+    SlotSet() = default;
+
+    /**
+     * @brief Constructs an empty set over the slots of \p fn.
+     *
+     * @param fn The function whose values or blocks are the elements.
+     */
+    explicit SlotSet(const Function* fn) {
+        reset(fn);
+    }
+
+    /**
+     * @brief Empties the set and sizes it for the slots of \p fn.
+     *
+     * @param fn The function whose values or blocks are the elements.
+     */
+    void reset(const Function* fn) {
+        words.assign((slot_count<KeyT>(fn) + 63) / 64, 0);
+    }
+
+    /**
+     * @brief Adds \p key, which must have a slot, to the set.
+     *
+     * @param key The element to add.
+     * @return true if \p key wasn't in the set yet, false otherwise.
+     */
+    bool insert(const KeyT* key) {
+        unsigned slot = key->get_slot();
+        assert(slot != Value::no_slot && "the key isn't in a function");
+        if (slot / 64 >= words.size())
+            words.resize(slot / 64 + 1, 0);
+
+        std::uint64_t bit = std::uint64_t(1) << (slot % 64);
+        if (words[slot / 64] & bit)
+            return false;
+        words[slot / 64] |= bit;
+        return true;
+    }
+
+    /**
+     * @brief Checks if \p key is in the set.
+     *
+     * @param key The element to look for, which may have no slot.
+     * @return true if \p key is in the set, false otherwise.
+     */
+    bool contains(const KeyT* key) const noexcept {
+        unsigned slot = key->get_slot();
+        return slot / 64 < words.size() && (words[slot / 64] >> (slot % 64) & 1);
+    }
+};
+
+
+template<typename T>
+using ValueMap = SlotMap<Value, T>;
+
+template<typename T>
+using BBMap = SlotMap<BB, T>;
+
+using ValueSet = SlotSet<Value>;
+using BBSet = SlotSet<BB>;
+
+
+
+#endif /* PCC_IR_CORE_SLOTMAP_H */
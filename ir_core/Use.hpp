@@ -10,35 +10,71 @@
  * @class Use
  * @brief A class that represents the use of a \c Value.
  *
- * This class links a \c Value to its \c User.
+ * This class links a \c Value to its \c User. Every \c Use of a \c Value
+ * is on that value's use-list, so a use is added or removed in constant time.
  */
 class Use
 {
     friend class User;
+    friend class Value;
+    template<typename UseT, typename UserT>
+    friend class user_iterator_t;
+
 private:
     User* user;
     Value* val;
+    Use* prev = nullptr; ///< The previous use of \c val.
+    Use* next = nullptr; ///< The next use of \c val.
+
+    /// An unused operand slot, which refers to nothing.
+    Use(): user(nullptr), val(nullptr) {}
+
+    Use(const Use&) = delete;
+    Use& operator=(const Use&) = delete;
 
-    Use() = delete;
+    ~Use() {
+        if (val)
+            val->remove_use(this);
+    }
 
     /**
-     * @brief Construct a new \c Use object.
+     * @brief Moves this use to the unused slot \p dst.
      * 
-     * The constructor automatically adds \p user to the list of users of \p val.
+     * \p dst takes this use's place on the use-list of the \c Value,
+     * and this use is left unused.
      *
-     * @param user The user of the value.
-     * @param val The value being used.
+     * @param dst The slot to move to.
      */
-    Use(User* user, Value* val): user(user), val(val) {
-        val->add_user(user);
+    void move_to(Use& dst) {
+        if (val && val->is_shared()) {
+            std::lock_guard<std::mutex> guard(val->use_list_lock());
+            relink_to(dst);
+        }
+        else {
+            relink_to(dst);
+        }
     }
 
-    Use(const Use&) = delete;
-    Use& operator=(const Use&) = delete;
-
-    ~Use() {
-        if (val)
-            val->remove_user(user);
+    void relink_to(Use& dst) noexcept {
+        dst.user = user;
+        dst.val = val;
+        dst.prev = prev;
+        dst.next = next;
+
+        if (val) {
+            if (prev)
+                prev->next = &dst;
+            else
+                val->use_head = &dst;
+
+            if (next)
+                next->prev = &dst;
+            else
+                val->use_tail = &dst;
+        }
+
+        val = nullptr;
+        prev = next = nullptr;
     }
 
 public:
@@ -71,10 +107,10 @@ public:
      */
     void set(Value *v) {
         if (val)
-            val->remove_user(user);
-        if (v)
-            v->add_user(user);
+            val->remove_use(this);
         val = v;
+        if (v)
+            v->add_use(this);
     }
 
 
@@ -105,4 +141,58 @@ public:
 };
 
 
+
+
+inline void Value::add_use(Use* use)
+{
+    if (is_shared()) {
+        std::lock_guard<std::mutex> guard(use_list_lock());
+        link_use(use);
+    }
+    else {
+        link_use(use);
+    }
+}
+
+
+inline void Value::remove_use(Use* use)
+{
+    if (is_shared()) {
+        std::lock_guard<std::mutex> guard(use_list_lock());
+        unlink_use(use);
+    }
+    else {
+        unlink_use(use);
+    }
+}
+
+
+inline void Value::link_use(Use* use) noexcept
+{
+    use->prev = use_tail;
+    use->next = nullptr;
+    if (use_tail)
+        use_tail->next = use;
+    else
+        use_head = use;
+    use_tail = use;
+    ++use_count;
+}
+
+
+inline void Value::unlink_use(Use* use) noexcept
+{
+    if (use->prev)
+        use->prev->next = use->next;
+    else
+        use_head = use->next;
+
+    if (use->next)
+        use->next->prev = use->prev;
+    else
+        use_tail = use->prev;
+    --use_count;
+}
+
+
 #endif /* PCC_IR_CORE_USE_H */
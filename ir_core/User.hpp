@@ -2,8 +2,8 @@
 #define PCC_IR_CORE_USER_H
 
 
-#include <vector>
-#include <memory>
+#include <algorithm>
+#include <cassert>
 #include "Use.hpp"
 
 
@@ -18,45 +18,105 @@
 class User: public Value
 {
 public:
-    using op_list = std::vector<Use*>;
-    using op_iterator = indirect_iterator<op_list::iterator, Use>;
-    using const_op_iterator = indirect_iterator<op_list::const_iterator, const Use>;
-    using op_size_type = typename op_list::size_type;
+    using op_iterator = Use*;
+    using const_op_iterator = const Use*;
+    using op_size_type = std::size_t;
 
 private:
-    op_list ops;
+    Use* ops; ///< The operands, in slots inline in the object or hung off it.
+    op_size_type num_ops = 0;
+    op_size_type capacity; ///< The number of slots in \c ops.
+    bool hung_off; ///< Whether \c ops is a heap array this \c User owns.
 
 protected:
     /**
-     * @brief Construct a new \c User object.
+     * @brief Operand slots allocated inline with a \c User of fixed arity.
+     *
+     * A subclass holds one as a member and hands \c slots to the \c User constructor.
+     *
+     * @tparam N The number of operands.
+     */
+    template <op_size_type N>
+    struct Operands {
+        Use slots[N];
+    };
+
+    /**
+     * @brief Construct a new \c User object whose operands are hung off it.
+     *
+     * The operand array is allocated on the first operand and grows as needed.
+     *
+     * @param ty Type of the \c Value this \c User represents.
+     * @param kind The kind of \c Value this \c User represents.
+     */
+    User(Type* ty, ValueKind kind):
+        Value(ty, kind), ops(nullptr), capacity(0), hung_off(true) {}
+
+    /**
+     * @brief Construct a new \c User object with a fixed number of operand slots.
      *
      * @param ty Type of the \c Value this \c User represents.
      * @param kind The kind of \c Value this \c User represents.
+     * @param slots Slots allocated with the object, usually a member of the subclass.
+     * @param n The number of slots.
      */
-    User(Type* ty, ValueKind kind): Value(ty, kind) {}
+    User(Type* ty, ValueKind kind, Use* slots, op_size_type n):
+        Value(ty, kind), ops(slots), capacity(n), hung_off(false) {}
 
     /**
      * @brief Destroy the \c User object.
      *
-     * @details Destructor ensures all associated \c Use objects are also deleted.
+     * @details Inline slots are destroyed with the subclass that holds them; a hung-off array is freed here.
      */
     ~User() {
-        for (auto iter = ops.begin(); iter != ops.end(); ++iter) {
-            delete *iter;
-        }
+        if (hung_off)
+            delete[] ops;
+    }
+
+    /**
+     * @brief Makes room for at least \p n operands.
+     *
+     * Operands hung off the object move to a bigger array; inline slots cannot grow.
+     *
+     * @param n The number of operands to make room for.
+     */
+    void reserve_operands(op_size_type n) {
+        if (n <= capacity)
+            return;
+        assert(hung_off && "operands inline in the object cannot grow");
+
+        op_size_type cap = std::max(n, capacity * 2);
+        Use* slots = new Use[cap];
+        for (op_size_type i = 0; i < num_ops; ++i)
+            ops[i].move_to(slots[i]);
+        delete[] ops;
+        ops = slots;
+        capacity = cap;
     }
 
     void add_operand(Value* op) {
-        ops.push_back(new Use(this, op));
+        reserve_operands(num_ops + 1);
+        Use& use = ops[num_ops++];
+        use.user = this;
+        use.set(op);
     }
 
     void add_operand(op_iterator before, Value* op) {
-        ops.insert(before.base(), new Use(this, op));
+        op_size_type i = before - ops;
+        reserve_operands(num_ops + 1);
+        for (op_size_type j = num_ops; j > i; --j)
+            ops[j - 1].move_to(ops[j]);
+        ++num_ops;
+
+        ops[i].user = this;
+        ops[i].set(op);
     }
 
     void remove_operand(op_size_type i) {
         set_operand(i, nullptr);
-        ops.erase(ops.begin() + i);
+        for (op_size_type j = i + 1; j < num_ops; ++j)
+            ops[j].move_to(ops[j - 1]);
+        --num_ops;
     }
 
 public:
@@ -66,7 +126,7 @@ public:
      * @return An iterator pointing to the beginning of the operand list.
      */
     op_iterator op_begin() noexcept { 
-        return make_indirect_iterator(ops.begin()); 
+        return ops; 
     }
 
     /**
@@ -75,7 +135,7 @@ public:
      * @return An iterator pointing to the end of the operand list.
      */
     op_iterator op_end() noexcept { 
-        return make_indirect_iterator(ops.end()); 
+        return ops + num_ops; 
     }
 
     /**
@@ -84,7 +144,7 @@ public:
      * @return An iterator pointing to the end of the operand list.
      */
     const_op_iterator op_begin() const noexcept { 
-        return make_indirect_iterator(ops.begin()); 
+        return ops; 
     }
 
      /**
@@ -93,7 +153,7 @@ public:
      * @return A const iterator pointing to the end of the operand list.
      */   
     const_op_iterator op_end() const noexcept { 
-        return make_indirect_iterator(ops.end()); 
+        return ops + num_ops; 
     }
 
     /**
@@ -102,7 +162,7 @@ public:
      * @return The number of operands in the operand list.
      */
     op_size_type get_num_operands() const noexcept {
-        return ops.size();
+        return num_ops;
     }
 
     /**
@@ -112,8 +172,8 @@ public:
      * @return The operand at the given position.
      */
     Use& get_operand(op_size_type i) { 
-        assert(i < ops.size());
-        return *ops[i]; 
+        assert(i < num_ops);
+        return ops[i]; 
     }
 
     /**
@@ -123,8 +183,8 @@ public:
      * @return A const reference to the operand at the given position.
      */
     const Use& get_operand(op_size_type i) const { 
-        assert(i < ops.size());
-        return *ops[i]; 
+        assert(i < num_ops);
+        return ops[i]; 
     }
 
     /**
@@ -134,7 +194,7 @@ public:
      * @param v The new operand to set.
      */
     void set_operand(op_size_type i, Value* v) {
-        *ops[i] = v;
+        ops[i] = v;
     }
 
     /**
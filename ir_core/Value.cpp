@@ -1,15 +1,21 @@
+#include <cstdint>
 #include "Value.hpp"
 #include "User.hpp"
 
 
+std::mutex& Value::use_list_lock() const noexcept
+{
+    static std::mutex locks[64];
+    return locks[(reinterpret_cast<std::uintptr_t>(this) / alignof(Value)) % 64];
+}
+
+
 void Value::replace_all_uses_with(Value* val)
 {
-    for (auto&& user = user_begin(); user != user_end(); ) {
-        auto old_user = user++;
-        for (auto&& op: old_user->get_operands()) {
-            if (op == this) {
-                op = val;
-            }
-        }
-    }
+    if (val == this)
+        return;
+
+    // each use leaves the list as it is pointed elsewhere
+    while (use_head)
+        use_head->set(val);
 }
\ No newline at end of file
@@ -2,16 +2,49 @@
 #define PCC_IR_CORE_VALUE_H
 
 
-#include <unordered_set>
 #include <assert.h>
+#include <iterator>
+#include <mutex>
 #include "iterator/indirect_iterator.hpp"
+#include "iterator/iterator_adaptor.hpp"
 #include "iterator/iterator_range.hpp"
 #include "type.hpp"
 
 
+class Use;
 class User;
 
 
+/**
+ * @class user_iterator_t
+ * @brief Iterates over the use-list of a \c Value, yielding the \c User of each \c Use.
+ * 
+ * @tparam UseT \c Use or <tt>const Use</tt>.
+ * @tparam UserT \c User or <tt>const User</tt>.
+ */
+template<typename UseT, typename UserT>
+class user_iterator_t: public iterator_adaptor<user_iterator_t<UseT, UserT>, UseT*, 
+                                               UserT, std::forward_iterator_tag>
+{
+    friend class iterator_core_access;
+    using super_t = iterator_adaptor<user_iterator_t<UseT, UserT>, UseT*, 
+                                     UserT, std::forward_iterator_tag>;
+
+public:
+    using reference = typename super_t::reference;
+
+    user_iterator_t() = default;
+    explicit user_iterator_t(UseT* use): super_t(use) {}
+
+    template<typename OtherUse, typename OtherUser>
+    user_iterator_t(const user_iterator_t<OtherUse, OtherUser>& other): super_t(other.base()) {}
+
+private:
+    reference dereference() const { return *this->base()->get_user(); }
+    void increment() { this->base_reference() = this->base()->next; }
+};
+
+
 /**
  * @enum ValueKind
  * @brief A enum class to categorize the type of \c Value.
@@ -86,14 +119,22 @@ class Value
     friend class Function;
 
 public:
-    using user_list = std::unordered_set<User*>;
-    using user_iterator = indirect_iterator<typename user_list::iterator, User>;
-    using const_user_iterator = indirect_iterator<typename user_list::const_iterator, const User>;
+    using user_iterator = user_iterator_t<Use, User>;
+    using const_user_iterator = user_iterator_t<const Use, const User>;
+
+    static constexpr unsigned no_slot = ~0u; ///< The slot of a \c Value outside any function.
     
 private:
     Type* ty;
     ValueKind kind;
-    user_list users;
+    unsigned use_count = 0; ///< The length of the use-list.
+    unsigned slot = no_slot; ///< The number of this \c Value in its \c Function.
+    unsigned name_id = 0; ///< The name interned in the \c IRContext, 0 if unnamed.
+
+    /// The use-list: every \c Use of this \c Value, doubly linked in the
+    /// order they were made to refer to it.
+    Use* use_head = nullptr;
+    Use* use_tail = nullptr;
 
 protected:
     Value() = delete;
@@ -116,14 +157,39 @@ protected:
         ty = new_ty;
     }
 
-    void add_user(User* inst) {
-        users.insert(inst);
+    void set_slot(unsigned new_slot) noexcept {
+        slot = new_slot;
+    }
+
+    void set_name_id(unsigned id) noexcept {
+        name_id = id;
     }
 
-    void remove_user(User* inst) {
-        users.erase(inst);
+    /**
+     * @brief Checks if the \c Value may be used by several functions.
+     *
+     * Constants, global variables and functions belong to no function,
+     * so passes running on different functions at once can change their
+     * use-lists together. Such changes hold \c use_list_lock().
+     *
+     * @return True for constants and globals, false otherwise.
+     */
+    bool is_shared() const noexcept {
+        return kind > ValueKind::CONSTANT_BEGIN && kind < ValueKind::CONSTANT_END;
     }
 
+    /**
+     * @brief Returns the lock guarding the use-list of a shared \c Value.
+     *
+     * Values share a fixed set of locks by address.
+     */
+    std::mutex& use_list_lock() const noexcept;
+
+    inline void add_use(Use* use);
+    inline void remove_use(Use* use);
+    inline void link_use(Use* use) noexcept;
+    inline void unlink_use(Use* use) noexcept;
+
 public:
 
     /**
@@ -144,13 +210,41 @@ public:
         return ty;
     }
 
+    /**
+     * @brief Get the slot of the \c Value in its \c Function.
+     *
+     * The basic blocks of a function are numbered densely from 0, and so
+     * are its other values: parameters, block parameters and instructions.
+     * Side tables index vectors with slots (see SlotMap.hpp).
+     *
+     * @return The slot, or \c no_slot for constants and globals.
+     */
+    unsigned get_slot() const noexcept {
+        return slot;
+    }
+
+    /**
+     * @brief Get the id of the name of the \c Value.
+     *
+     * Names are interned in the \c IRContext, which maps the id back
+     * to the name without hashing.
+     *
+     * @return The id of the name, or 0 if the \c Value is unnamed.
+     */
+    unsigned get_name_id() const noexcept {
+        return name_id;
+    }
+
     /**
      * @brief Get an iterator to the beginning of the users.
      *
+     * A \c User appears once for each of its operands that refers to
+     * this \c Value.
+     *
      * @return An iterator pointing to the beginning of the users.
      */
     user_iterator user_begin() noexcept {
-        return user_iterator(users.begin());
+        return user_iterator(use_head);
     }
 
     /**
@@ -159,20 +253,23 @@ public:
      * @return An iterator pointing to the end of the users.
      */
     user_iterator user_end() noexcept {
-        return user_iterator(users.end());
+        return user_iterator(nullptr);
     }
                         
     const_user_iterator user_begin() const noexcept {
-        return const_user_iterator(users.begin());
+        return const_user_iterator(use_head);
     }
 
     const_user_iterator user_end() const noexcept {
-        return const_user_iterator(users.end());
+        return const_user_iterator(nullptr);
     }
 
     /**
      * @brief Get a range of all users of this \c Value.
      *
+     * The users of a constant or global may be walked only while no pass
+     * is running on a function that uses it.
+     *
      * @return A range that includes all users of this \c Value.
      */
     iterator_range<user_iterator> get_users() noexcept {
@@ -189,12 +286,15 @@ public:
      * @return True if this \c Value has users, false otherwise.
      */
     bool user_empty() const noexcept {
-        return !users.empty();
+        return !use_head;
     }
 
     /**
      * @brief Replaces all uses of this \c Value with another \c Value.
      *
+     * Like walking the users, this must not race with passes on other
+     * functions if this \c Value is a constant or global.
+     *
      * @param val The new \c Value.
      */
     void replace_all_uses_with(Value* val);
@@ -1,6 +1,10 @@
 #include <string.h>
 #include <iostream>
 #include "tokenize.hpp"
+#include "scan.hpp"
+#include "source.hpp"
+#include "preprocess.hpp"
+#include "token_cache.hpp"
 #include "parse.hpp"
 #include "codegen.hpp"
 #include "utils/util.hpp"
@@ -16,13 +20,27 @@
 
 static char *opt_o;
 static char *input_path;
+static int pass_jobs = 1;
 
 
 static void usage(int status) {
-    fprintf(stderr, "pcc [ -o <path> ] <file>\n");
+    fprintf(stderr, "pcc [ -o <path> ] [ -I <dir> ] [ --scan=auto|scalar|sse2|avx2 ]\n"
+                    "    [ --token-cache=<dir> ] [ -j <jobs> ] [ --lazy-static ] <file>\n");
     exit(status);
 }
 
+// -j: how many threads may work on one input
+static void set_jobs(char *arg) {
+    char *end;
+    long n = strtol(arg, &end, 10);
+    if (*end || n < 1)
+        error("invalid number of jobs: %s", arg);
+    set_tokenize_jobs(n);
+    set_parse_jobs(n);
+    pass_jobs = n;
+}
+
+
 static void paese_args(int argc, char **argv) {
     for (int i = 1; i < argc; ++i) {
         if(!strcmp(argv[i], "--help")) {
@@ -43,6 +61,66 @@ static void paese_args(int argc, char **argv) {
             continue;
         }
 
+        // parse -I dir
+        if (!strcmp(argv[i], "-I")) {
+            if(!argv[++i])
+                usage(1);
+            add_include_path(argv[i]);
+            continue;
+        }
+
+        // parse -Idir
+        if(!strncmp(argv[i], "-I", 2)) {
+            add_include_path(argv[i] + 2);
+            continue;
+        }
+
+        // parse --scan=mode, which picks the tokenizer's scanner
+        if (!strncmp(argv[i], "--scan=", 7)) {
+            char *mode = argv[i] + 7;
+            ScanMode m;
+            if (!strcmp(mode, "auto"))
+                m = SCAN_AUTO;
+            else if (!strcmp(mode, "scalar"))
+                m = SCAN_SCALAR;
+            else if (!strcmp(mode, "sse2"))
+                m = SCAN_SSE2;
+            else if (!strcmp(mode, "avx2"))
+                m = SCAN_AVX2;
+            else
+                error("unknown scan mode: %s", mode);
+
+            if (!set_scan_mode(m))
+                error("scan mode not supported on this machine: %s", mode);
+            continue;
+        }
+
+        // parse -j jobs
+        if (!strcmp(argv[i], "-j")) {
+            if(!argv[++i])
+                usage(1);
+            set_jobs(argv[i]);
+            continue;
+        }
+
+        // parse -jjobs
+        if(!strncmp(argv[i], "-j", 2)) {
+            set_jobs(argv[i] + 2);
+            continue;
+        }
+
+        // parse --token-cache=dir
+        if (!strncmp(argv[i], "--token-cache=", 14)) {
+            set_token_cache_dir(argv[i] + 14);
+            continue;
+        }
+
+        // parse --lazy-static
+        if (!strcmp(argv[i], "--lazy-static")) {
+            set_lazy_static(true);
+            continue;
+        }
+
         if (argv[i][0] == '-' && argv[i][1] != '\0') 
             error("unknown argument: %s", argv[i]);
 
@@ -70,20 +148,29 @@ int main(int argc, char **argv)
     paese_args(argc, argv);
 
     Token *tok = tokenize_file(input_path);
+    tok = preprocess(tok);
     Obj *prog = parse(tok);
 
 #ifdef GEN_IR
     IRContext context;
     Module *module = gen_ir(prog, context);
-    mem2reg(module);
-    global_value_numbering(module);
-    dead_code_elimination(module);
+    // the IR doesn't refer back to the source
+    free_ast();
+    free_tokens();
+    mem2reg(module, pass_jobs);
+    global_value_numbering(module, pass_jobs);
+    dead_code_elimination(module, pass_jobs);
     module->print(std::cout, false);
 #else
     FILE *out = open_file(opt_o);
-    // .file file_number file_name
-    fprintf(out, ".file 1 \"%s\"\n", input_path);
+    // .file file_number file_name, for the input and every header
+    int num_files;
+    SourceFile **files = get_input_files(&num_files);
+    for (int i = 0; i < num_files; ++i)
+        fprintf(out, ".file %d \"%s\"\n", files[i]->file_no, files[i]->name);
     codegen(prog, out);
+    free_ast();
+    free_tokens();
 
 #endif
     return 0;
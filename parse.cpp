@@ -6,12 +6,21 @@
 // then construct an AST node representing a statement.
 
 #include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "parse.hpp"
 #include "tokenize.hpp"
 #include "type.hpp"
 #include "utils/util.hpp"
+#include "utils/arena.hpp"
+#include "utils/parallel.hpp"
 
 
 // Scope for local variables, global varables, typedefs
@@ -19,8 +28,12 @@
 typedef struct VarScope VarScope;
 struct VarScope
 {
-  VarScope *next;
+  VarScope *next;     // next binding made in the same block scope
+  VarScope *shadowed; // binding of the same name this one hides
   char *name;
+  int sym;
+  int seq;            // the number of file scope bindings made before
+                      // this one, if this is one
   Obj *var;
   Type *type_def;
   Type *enum_ty;
@@ -32,7 +45,10 @@ typedef struct TagScope TagScope;
 struct TagScope
 {
   TagScope *next;
+  TagScope *shadowed;
   char *name;
+  int sym;
+  int seq;
   Type *ty;
 };
 
@@ -43,6 +59,23 @@ typedef struct
   bool is_static;
 } VarAttr;
 
+// a parameter of a function declarator
+typedef struct Param Param;
+struct Param
+{
+  Param *next;
+  Type *ty;
+  Token *name;
+};
+
+// what a declarator declares besides its type. types are shared,
+// so names can't be kept in them.
+typedef struct
+{
+  Token *name;
+  Param *params; // if the declarator declares a function
+} DeclName;
+
 // represents a block scope
 typedef struct Scope Scope;
 struct Scope
@@ -50,46 +83,108 @@ struct Scope
   Scope *next;
 
   // C has two block scopes: one is for variables/typedefs and
-  // the other is for struct/unioin/enum tags
+  // the other is for struct/unioin/enum tags.
+  // these list the bindings made in this scope, newest first
   VarScope *vars;
   TagScope *tags;
 };
 
+// The innermost visible binding of every identifier, indexed by
+// symbol id - SYM_IDENT, so a lookup doesn't depend on how many names
+// are in scope. Leaving a scope pops the bindings made in it, which
+// uncovers the ones they shadowed.
+struct Bindings
+{
+  VarScope **vars;
+  TagScope **tags;
+  int size;
+
+  ~Bindings()
+  {
+    free(vars);
+    free(tags);
+  }
+};
+
+// Function bodies may be parsed on several threads at once (see
+// parse_bodies()), so block scopes are kept apart from the file scope.
+// File scope bindings are only made by the thread running parse(), and
+// don't change while bodies are being parsed. The block scopes of a
+// body belong to the thread parsing it, and are searched first.
+static Bindings file_bindings;
+static thread_local Bindings block_bindings;
+
+static Scope file_scope;
+static thread_local Scope *scope = &file_scope;
+
+// the number of file scope bindings made so far
+static int num_file_bindings;
+
+// A function body sees only the file scope bindings made before it,
+// even if it is parsed after the whole file scope has been read.
+static thread_local int visible_file_bindings = INT_MAX;
+
 // All local variable instances created during parsing are
 // accumulated to this list.
-static Obj *locals;
+static thread_local Obj *locals;
 
 // global variables are stored in during parsing
-static Obj *globals;
-static Obj *globals_end;
+static thread_local Obj *globals;
+static thread_local Obj *globals_end;
+
+// every AST node, until free_ast()
+static Arena node_arena(1024 * 1024);
+static std::vector<Arena> body_arenas;
 
-static Scope *scope = new Scope;
+// where the nodes of this thread go
+static thread_local Arena *cur_node_arena = &node_arena;
 
 // points to the function object the parser is currently parsing
-static Obj *current_fn;
+static thread_local Obj *current_fn;
+
+// the number of threads function bodies are parsed on
+static int parse_jobs = 1;
+
+// parse static function bodies only if something reachable calls them
+static bool lazy_static;
+
+// a function body set aside while the file scope is read
+typedef struct
+{
+  Obj *fn;
+  Param *params;
+  Token *tok;     // the opening brace
+  int visible;    // file scope bindings made before the body
+  int sym;        // the function's name
+  bool lazy;      // parsed only once referenced
+  bool parsed = false;
+  Obj *literals = nullptr;  // anonymous globals made by the body, in order
+  char *error = nullptr;    // the first error in the body, if it has one
+  std::vector<int> refs = {};  // names of the functions the body refers to
+} DeferredBody;
+
+// bodies are put here, not parsed, by function() while this is set
+static std::vector<DeferredBody> *deferred_bodies;
+
+// where the body being parsed records the functions it refers to
+static thread_local std::vector<int> *fn_refs;
+
+// the number of string literals in each lazy body that was never parsed
+static std::unordered_map<Obj *, int> skipped_literals;
 
 static bool is_typename(Token *tok);
 static Type *declspec(Token **rest, Token *tok, VarAttr *attr);
 static Type *enum_specifier(Token **rest, Token *tok);
 static Type *struct_decl(Token **rest, Token *tok);
 static Type *union_decl(Token **rest, Token *tok);
-static Type *declarator(Token **rest, Token *tok, Type *ty);
+static Type *declarator(Token **rest, Token *tok, Type *ty, DeclName *decl);
 static Node *declaration(Token **rest, Token *tok, Type *basety);
 static Node *compound_stmt(Token **rest, Token *tok);
 static Node *expr_stmt(Token **rest, Token *tok);
 static Node *expr(Token **rest, Token *tok);
 static Node *assign(Token **rest, Token *tok);
-static Node *logor(Token **rest, Token *tok);
-static Node *logand(Token **rest, Token *tok);
-static Node *bitor_(Token **rest, Token *tok);
-static Node *bitxor_(Token **rest, Token *tok);
-static Node *bitand_(Token **rest, Token *tok);
-static Node *equality(Token **rest, Token *tok);
-static Node *relational(Token **rest, Token *tok);
-static Node *add(Token **rest, Token *tok);
 static Node *new_add(Node *lhs, Node *rhs, Token *tok);
 static Node *new_sub(Node *lhs, Node *rhs, Token *tok);
-static Node *mul(Token **rest, Token *tok);
 static Node *cast(Token **rest, Token *tok);
 static Node *postfix(Token **rest, Token *tok);
 static Node *unary(Token **rest, Token *tok);
@@ -103,44 +198,106 @@ static void enter_scope()
   scope = sc;
 }
 
+// only ever leaves block scopes
 static void leave_scope()
 {
+  for (VarScope *sc = scope->vars; sc; sc = sc->next)
+    block_bindings.vars[sc->sym - SYM_IDENT] = sc->shadowed;
+  for (TagScope *sc = scope->tags; sc; sc = sc->next)
+    block_bindings.tags[sc->sym - SYM_IDENT] = sc->shadowed;
   scope = scope->next;
 }
 
-// Find a variable by name.
-static VarScope *find_var(Token *tok)
+// the bindings of the current scope, with room for symbol id `sym`
+static Bindings *current_bindings(int sym)
 {
-  for (Scope *sc = scope; sc; sc = sc->next)
+  Bindings *b = scope == &file_scope ? &file_bindings : &block_bindings;
+  int n = sym - SYM_IDENT + 1;
+  if (n <= b->size)
+    return b;
+
+  int cap = b->size ? b->size : 1024;
+  while (cap < n)
+    cap *= 2;
+
+  b->vars = (VarScope**)realloc(b->vars, sizeof(VarScope*) * cap);
+  b->tags = (TagScope**)realloc(b->tags, sizeof(TagScope*) * cap);
+  for (int i = b->size; i < cap; i++)
   {
-    for (VarScope *sc2 = sc->vars; sc2; sc2 = sc2->next)
-    {
-      if (equal(tok, sc2->name))
-        return sc2;
-    }
+    b->vars[i] = NULL;
+    b->tags[i] = NULL;
   }
-  return NULL;
+  b->size = cap;
+  return b;
+}
+
+// Find a variable by name.
+static VarScope *find_var(Token *tok)
+{
+  int i = tok->sym - SYM_IDENT;
+  if (i < 0)
+    return NULL;
+  if (i < block_bindings.size && block_bindings.vars[i])
+    return block_bindings.vars[i];
+  if (i >= file_bindings.size)
+    return NULL;
+
+  VarScope *sc = file_bindings.vars[i];
+  while (sc && sc->seq >= visible_file_bindings)
+    sc = sc->shadowed;
+  return sc;
 }
 
 static Type *find_tag(Token *tok)
 {
-  for (Scope *sc = scope; sc; sc = sc->next)
+  int i = tok->sym - SYM_IDENT;
+  if (i < 0)
+    return NULL;
+  if (i < block_bindings.size && block_bindings.tags[i])
+    return block_bindings.tags[i]->ty;
+  if (i >= file_bindings.size)
+    return NULL;
+
+  TagScope *sc = file_bindings.tags[i];
+  while (sc && sc->seq >= visible_file_bindings)
+    sc = sc->shadowed;
+  return sc ? sc->ty : NULL;
+}
+
+// the size of a node of `kind`: the members every node has plus
+// the part of the union `kind` uses
+#define NODE_SIZE_TO(member) \
+  (offsetof(Node, member) + sizeof(((Node*)0)->member))
+
+static size_t node_size(NodeKind kind)
+{
+  switch (kind)
   {
-    for (TagScope *sc2 = sc->tags; sc2; sc2 = sc2->next)
-    {
-      if (equal(tok, sc2->name))
-      {
-        return sc2->ty;
-      }
-    }
+  case ND_NUM:
+    return NODE_SIZE_TO(val);
+  case ND_VAR:
+    return NODE_SIZE_TO(var);
+  case ND_BLOCK:
+  case ND_STMT_EXPR:
+    return NODE_SIZE_TO(body);
+  case ND_FUNCALL:
+    return NODE_SIZE_TO(args);
+  case ND_IF:
+    return NODE_SIZE_TO(els);
+  case ND_FOR:
+    return NODE_SIZE_TO(inc);
+  case ND_MEMBER:
+    return NODE_SIZE_TO(member);
+  default:
+    return is_binary(kind) ? NODE_SIZE_TO(rhs) : NODE_SIZE_TO(lhs);
   }
-
-  return NULL;
 }
 
 static Node *new_node(NodeKind kind, Token *tok)
 {
-  Node *node = (Node*)calloc(1, sizeof(Node));
+  size_t size = node_size(kind);
+  Node *node = (Node*)cur_node_arena->allocate(size, alignof(Node));
+  memset(node, 0, size);
   node->kind = kind;
   node->tok = tok;
   return node;
@@ -151,6 +308,7 @@ static Node *new_binary(NodeKind kind, Node *lhs, Node *rhs, Token *tok)
   Node *node = new_node(kind, tok);
   node->lhs = lhs;
   node->rhs = rhs;
+  add_type(node);
   return node;
 }
 
@@ -158,6 +316,7 @@ static Node *new_unary(NodeKind kind, Node *expr, Token *tok)
 {
   Node *node = new_node(kind, tok);
   node->lhs = expr;
+  add_type(node);
   return node;
 }
 
@@ -165,6 +324,7 @@ static Node *new_num(int64_t val, Token *tok)
 {
   Node *node = new_node(ND_NUM, tok);
   node->val = val;
+  add_type(node);
   return node;
 }
 
@@ -179,40 +339,267 @@ static Node *new_var_node(Obj *var, Token *tok)
 {
   Node *node = new_node(ND_VAR, tok);
   node->var = var;
+  add_type(node);
+  return node;
+}
+
+//
+// Constant folding
+//
+// Operators are folded as they are built, so constant subtrees such as
+// sizeof arithmetic, enum math or pointer scaling never make it into the
+// AST. Operands have already been converted by add_type(), so a constant
+// is always evaluated in the type C gives it.
+//
+
+// the value of constant `val` converted to integer or pointer type `ty`
+static int64_t convert_const(Type *ty, int64_t val)
+{
+  switch (ty->kind)
+  {
+  case TY_BOOL:
+    return val != 0;
+  case TY_CHAR:
+    return (int8_t)val;
+  case TY_SHORT:
+    return (int16_t)val;
+  case TY_INT:
+  case TY_ENUM:
+    return (int32_t)val;
+  default:
+    return val;
+  }
+}
+
+// Evaluates `lhs op rhs` for operands of type `ty`. Returns false if the
+// operation traps, so that it's left for the program to hit at run time.
+static bool eval_binary(NodeKind kind, Type *ty, int64_t lhs, int64_t rhs, int64_t *val)
+{
+  // signed overflow wraps around, as it does in generated code
+  uint64_t l = lhs, r = rhs;
+
+  switch (kind)
+  {
+  case ND_ADD:
+    *val = l + r;
+    return true;
+  case ND_SUB:
+    *val = l - r;
+    return true;
+  case ND_MUL:
+    *val = l * r;
+    return true;
+  case ND_DIV:
+  case ND_MOD:
+    if (rhs == 0 || (rhs == -1 && lhs == (ty->size == 8 ? INT64_MIN : INT32_MIN)))
+      return false;
+    *val = kind == ND_DIV ? lhs / rhs : lhs % rhs;
+    return true;
+  case ND_BITAND:
+    *val = lhs & rhs;
+    return true;
+  case ND_BITOR:
+    *val = lhs | rhs;
+    return true;
+  case ND_BITXOR:
+    *val = lhs ^ rhs;
+    return true;
+  case ND_EQ:
+    *val = lhs == rhs;
+    return true;
+  case ND_NE:
+    *val = lhs != rhs;
+    return true;
+  case ND_LT:
+    *val = lhs < rhs;
+    return true;
+  case ND_LE:
+    *val = lhs <= rhs;
+    return true;
+  case ND_LOGAND:
+    *val = lhs && rhs;
+    return true;
+  case ND_LOGOR:
+    *val = lhs || rhs;
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool is_commutative(NodeKind kind)
+{
+  return kind == ND_ADD || kind == ND_MUL || kind == ND_BITAND ||
+         kind == ND_BITOR || kind == ND_BITXOR || kind == ND_EQ || kind == ND_NE;
+}
+
+// true for operators where `(x op c1) op c2` is `x op (c1 op c2)`
+static bool is_associative(NodeKind kind)
+{
+  return kind == ND_ADD || kind == ND_MUL || kind == ND_BITAND ||
+         kind == ND_BITOR || kind == ND_BITXOR;
+}
+
+// true if `x op c` is just `x`
+static bool is_identity(NodeKind kind, int64_t c)
+{
+  switch (kind)
+  {
+  case ND_ADD:
+  case ND_SUB:
+  case ND_BITOR:
+  case ND_BITXOR:
+    return c == 0;
+  case ND_MUL:
+  case ND_DIV:
+    return c == 1;
+  default:
+    return false;
+  }
+}
+
+// nodes that gen_addr() accepts; replacing `x + 0` by one of these
+// would turn an rvalue into an lvalue
+static bool may_be_lvalue(Node *node)
+{
+  NodeKind k = node->kind;
+  return k == ND_VAR || k == ND_DEREF || k == ND_MEMBER || k == ND_COMMA;
+}
+
+// turns `node` into constant `val` of its type, reusing constant operand `num`
+static Node *to_const(Node *node, Node *num, int64_t val)
+{
+  num->val = convert_const(node->ty, val);
+  num->ty = node->ty;
+  num->tok = node->tok;
+  return num;
+}
+
+// Folds a unary or binary operator node that has just been built, and
+// otherwise canonicalizes it: constants go on the right of commutative
+// operators, and `(x op c1) op c2` becomes `x op (c1 op c2)`.
+static Node *fold(Node *node)
+{
+  switch (node->kind)
+  {
+  case ND_NEG:
+    if (node->lhs->kind == ND_NUM)
+      return to_const(node, node->lhs, 0 - (uint64_t)node->lhs->val);
+    return node;
+  case ND_NOT:
+    if (node->lhs->kind == ND_NUM)
+      return to_const(node, node->lhs, !node->lhs->val);
+    return node;
+  case ND_BITNOT:
+    if (node->lhs->kind == ND_NUM)
+      return to_const(node, node->lhs, ~node->lhs->val);
+    return node;
+  case ND_LOGAND:
+  case ND_LOGOR:
+    // `0 && x` and `1 || x` never evaluate x
+    if (node->lhs->kind == ND_NUM &&
+        (node->lhs->val != 0) == (node->kind == ND_LOGOR))
+      return to_const(node, node->lhs, node->kind == ND_LOGOR);
+    break;
+  default:
+    if (!is_binary(node->kind))
+      return node;
+  }
+
+  Node *lhs = node->lhs;
+  Node *rhs = node->rhs;
+  int64_t val;
+
+  if (lhs->kind == ND_NUM && rhs->kind == ND_NUM)
+  {
+    if (eval_binary(node->kind, lhs->ty, lhs->val, rhs->val, &val))
+      return to_const(node, lhs, val);
+    return node;
+  }
+
+  if (!is_integer(node->ty) && node->ty->kind != TY_PTR)
+    return node;
+
+  // c op x => x op c
+  if (lhs->kind == ND_NUM && is_commutative(node->kind) && is_integer(node->ty))
+  {
+    node->lhs = rhs;
+    node->rhs = lhs;
+    lhs = node->lhs;
+    rhs = node->rhs;
+  }
+
+  if (rhs->kind != ND_NUM)
+    return node;
+
+  // (x op c1) op c2 => x op (c1 op c2), where a sum may mix + and -,
+  // as in (x + c1) - c2 => x + (c1 - c2)
+  NodeKind combine = lhs->kind != node->kind ? ND_SUB
+                   : node->kind == ND_SUB     ? ND_ADD
+                                              : node->kind;
+  bool additive = (lhs->kind == ND_ADD || lhs->kind == ND_SUB) &&
+                  (node->kind == ND_ADD || node->kind == ND_SUB);
+  if ((additive || (is_associative(node->kind) && lhs->kind == node->kind)) &&
+      lhs->ty == node->ty && lhs->rhs->kind == ND_NUM &&
+      eval_binary(combine, node->ty, lhs->rhs->val, rhs->val, &val))
+  {
+    lhs->rhs->val = convert_const(lhs->rhs->ty, val);
+    node = lhs;
+    lhs = node->lhs;
+    rhs = node->rhs;
+  }
+
+  // x op identity => x
+  if (is_identity(node->kind, rhs->val) && lhs->ty == node->ty && !may_be_lvalue(lhs))
+    return lhs;
   return node;
 }
 
 Node *new_cast(Node *expr, Type *ty)
 {
-  add_type(expr);
+  if (expr->kind == ND_NUM && (is_integer(ty) || ty->kind == TY_PTR))
+  {
+    expr->val = convert_const(ty, expr->val);
+    expr->ty = ty;
+    return expr;
+  }
 
-  Node *node = (Node*)calloc(1, sizeof(Node));
-  node->kind = ND_CAST;
-  node->tok = expr->tok;
+  Node *node = new_node(ND_CAST, expr->tok);
   node->lhs = expr;
-  node->ty = copy_type(ty);
+  node->ty = ty;
   return node;
 }
 
-static VarScope *push_scope(char *name)
+static char *get_ident(Token *tok);
+
+static VarScope *push_scope(Token *tok)
 {
   VarScope *sc = (VarScope*)calloc(1, sizeof(VarScope));
-  sc->name = name;
+  sc->name = get_ident(tok);
+  sc->sym = tok->sym;
   sc->next = scope->vars;
   scope->vars = sc;
+
+  Bindings *b = current_bindings(sc->sym);
+  if (b == &file_bindings)
+    sc->seq = num_file_bindings++;
+  sc->shadowed = b->vars[sc->sym - SYM_IDENT];
+  b->vars[sc->sym - SYM_IDENT] = sc;
   return sc;
 }
 
-static Obj *new_var(char *name, Type *ty)
+// makes a variable named `name`, or an anonymous one if `name` is NULL
+static Obj *new_var(Token *name, Type *ty)
 {
   Obj *var = (Obj*)calloc(1, sizeof(Obj));
-  var->name = name;
   var->ty = ty;
-  push_scope(name)->var = var;
+  if (name)
+    push_scope(name)->var = var;
+  var->name = name ? get_ident(name) : NULL;
   return var;
 }
 
-static Obj *new_lvar(char *name, Type *ty)
+static Obj *new_lvar(Token *name, Type *ty)
 {
   Obj *var = new_var(name, ty);
   var->is_local = true;
@@ -221,7 +608,7 @@ static Obj *new_lvar(char *name, Type *ty)
   return var;
 }
 
-static Obj *new_gvar(char *name, Type *ty)
+static Obj *new_gvar(Token *name, Type *ty)
 {
   Obj *var = new_var(name, ty);
   if (!globals) {
@@ -237,15 +624,18 @@ static Obj *new_gvar(char *name, Type *ty)
   return var;
 }
 
+static int unique_id;
+
 static char *new_unique_name()
 {
-  static int id = 0;
-  return format(".L..%d", id++);
+  return format(".L..%d", unique_id++);
 }
 
+// anonymous globals are named by parse() once they're all made, so
+// that names don't depend on the order bodies are parsed in
 static Obj *new_anon_gvar(Type *ty)
 {
-  return new_gvar(new_unique_name(), ty);
+  return new_gvar(NULL, ty);
 }
 
 static Obj *new_string_literal(char *p, Type *ty)
@@ -291,9 +681,16 @@ static void push_tag_scope(Token *tok, Type *ty)
 {
   TagScope *sc = (TagScope*)calloc(1, sizeof(TagScope));
   sc->name = strndup(tok->loc, tok->len);
+  sc->sym = tok->sym;
   sc->ty = ty;
   sc->next = scope->tags;
   scope->tags = sc;
+
+  Bindings *b = current_bindings(sc->sym);
+  if (b == &file_bindings)
+    sc->seq = num_file_bindings++;
+  sc->shadowed = b->tags[sc->sym - SYM_IDENT];
+  b->tags[sc->sym - SYM_IDENT] = sc;
 }
 
 // declspec = ("void" | "_Bool" | "char" | "short" | "int" | "long"
@@ -322,12 +719,12 @@ static Type *declspec(Token **rest, Token *tok, VarAttr *attr)
   while (is_typename(tok))
   {
     // handle storage class specifiers
-    if (equal(tok, "typedef") || equal(tok, "static"))
+    if (equal(tok, KW_TYPEDEF) || equal(tok, KW_STATIC))
     {
       if (!attr)
         error_tok(tok, "storage class specifier is not allowed in this context");
       
-      if (equal(tok, "typedef")) {
+      if (equal(tok, KW_TYPEDEF)) {
         attr->is_typedef = true;
       }
       else {
@@ -342,20 +739,20 @@ static Type *declspec(Token **rest, Token *tok, VarAttr *attr)
 
     // handle user-defined type
     Type *ty2 = find_typedef(tok);
-    if (equal(tok, "struct") || equal(tok, "union") || equal(tok, "enum") || ty2)
+    if (equal(tok, KW_STRUCT) || equal(tok, KW_UNION) || equal(tok, KW_ENUM) || ty2)
     {
       if (counter)
         break;
 
-      if (equal(tok, "struct"))
+      if (equal(tok, KW_STRUCT))
       {
         ty = struct_decl(&tok, tok->next);
       }
-      else if (equal(tok, "union"))
+      else if (equal(tok, KW_UNION))
       {
         ty = union_decl(&tok, tok->next);
       }
-      else if (equal(tok, "enum"))
+      else if (equal(tok, KW_ENUM))
       {
         ty = enum_specifier(&tok, tok->next);
       }
@@ -370,17 +767,17 @@ static Type *declspec(Token **rest, Token *tok, VarAttr *attr)
     }
 
     // handle built-in type
-    if (equal(tok, "void"))
+    if (equal(tok, KW_VOID))
       counter += VOID;
-    else if (equal(tok, "_Bool"))
+    else if (equal(tok, KW_BOOL))
       counter += BOOL;
-    else if (equal(tok, "char"))
+    else if (equal(tok, KW_CHAR))
       counter += CHAR;
-    else if (equal(tok, "short"))
+    else if (equal(tok, KW_SHORT))
       counter += SHORT;
-    else if (equal(tok, "int"))
+    else if (equal(tok, KW_INT))
       counter += INT;
-    else if (equal(tok, "long"))
+    else if (equal(tok, KW_LONG))
       counter += LONG;
     else
       unreachable();
@@ -422,24 +819,35 @@ static Type *declspec(Token **rest, Token *tok, VarAttr *attr)
 
 // func-params = (param ("," param)*)? ")"
 // param       = declspec declarator
-static Type *func_params(Token **rest, Token *tok, Type *ty)
+static Type *func_params(Token **rest, Token *tok, Type *ty, DeclName *decl)
 {
-  Type head = {};
-  Type *cur = &head;
+  Param head = {};
+  Param *cur = &head;
+  int num_params = 0;
 
-  while (!equal(tok, ")"))
+  while (!equal(tok, ')'))
   {
     if (cur != &head)
     {
-      tok = skip(tok, ",");
+      tok = skip(tok, ',');
     }
     Type *basety = declspec(&tok, tok, NULL);
-    Type *ty = declarator(&tok, tok, basety);
-    cur = cur->next = copy_type(ty);
+    DeclName name = {};
+    Param *param = (Param*)calloc(1, sizeof(Param));
+    param->ty = declarator(&tok, tok, basety, &name);
+    param->name = name.name;
+    cur = cur->next = param;
+    num_params++;
   }
 
-  ty = func_type(ty);
-  ty->params = head.next;
+  Type **params = (Type**)calloc(num_params, sizeof(Type*));
+  int i = 0;
+  for (Param *param = head.next; param; param = param->next)
+    params[i++] = param->ty;
+
+  ty = func_type(ty, params, num_params);
+  free(params);
+  decl->params = head.next;
   *rest = tok->next;
   return ty;
 }
@@ -447,18 +855,18 @@ static Type *func_params(Token **rest, Token *tok, Type *ty)
 // type-suffix -> "(" func-params
 //              | "[" num "]" type-suffix
 //              | ε
-static Type *type_suffix(Token **rest, Token *tok, Type *ty)
+static Type *type_suffix(Token **rest, Token *tok, Type *ty, DeclName *decl)
 {
-  if (equal(tok, "("))
+  if (equal(tok, '('))
   {
-    return func_params(rest, tok->next, ty);
+    return func_params(rest, tok->next, ty, decl);
   }
 
-  if (equal(tok, "["))
+  if (equal(tok, '['))
   {
     int sz = get_number(tok->next);
-    tok = skip(tok->next->next, "]");
-    ty = type_suffix(rest, tok, ty);
+    tok = skip(tok->next->next, ']');
+    ty = type_suffix(rest, tok, ty, decl);
     return array_of(ty, sz);
   }
 
@@ -467,49 +875,49 @@ static Type *type_suffix(Token **rest, Token *tok, Type *ty)
 }
 
 // declarator -> "*"* ("(" ident ")" | "(" declarator ")" | ident) type-suffix
-static Type *declarator(Token **rest, Token *tok, Type *ty)
+static Type *declarator(Token **rest, Token *tok, Type *ty, DeclName *decl)
 {
-  while (consume(&tok, tok, "*"))
+  while (consume(&tok, tok, '*'))
     ty = pointer_to(ty);
 
-  if (equal(tok, "("))
+  if (equal(tok, '('))
   {
     Token *start = tok;
-    Type dummy = {};
-    declarator(&tok, start->next, &dummy);
-    tok = skip(tok, ")");
-    ty = type_suffix(rest, tok, ty);
-    return declarator(&tok, start->next, ty);
+    DeclName ignored = {};
+    declarator(&tok, start->next, ty_void, &ignored);
+    tok = skip(tok, ')');
+    ty = type_suffix(rest, tok, ty, decl);
+    return declarator(&tok, start->next, ty, decl);
   }
 
   if (tok->kind != TK_IDENT)
     error_tok(tok, "expected a variable name");
 
-  ty = type_suffix(rest, tok->next, ty);
-  ty->name = tok;
+  ty = type_suffix(rest, tok->next, ty, decl);
+  decl->name = tok;
   return ty;
 }
 
 // abstract-declarator = "*"* ("(" abstract-declarator ")")? type-suffix
 static Type *abstract_declarator(Token **rest, Token *tok, Type *ty)
 {
-  while (equal(tok, "*"))
+  while (equal(tok, '*'))
   {
     ty = pointer_to(ty);
     tok = tok->next;
   }
 
-  if (equal(tok, "("))
+  DeclName ignored = {};
+  if (equal(tok, '('))
   {
     Token *start = tok;
-    Type dummy = {};
-    abstract_declarator(&tok, start->next, &dummy);
-    tok = skip(tok, ")");
-    ty = type_suffix(rest, tok, ty);
+    abstract_declarator(&tok, start->next, ty_void);
+    tok = skip(tok, ')');
+    ty = type_suffix(rest, tok, ty, &ignored);
     return abstract_declarator(&tok, start->next, ty);
   }
 
-  return type_suffix(rest, tok, ty);
+  return type_suffix(rest, tok, ty, &ignored);
 }
 
 // type-name = declspec abstract-declarator
@@ -534,7 +942,7 @@ static Type *enum_specifier(Token **rest, Token *tok)
     tok = tok->next;
   }
 
-  if (tag && !equal(tok, "{"))
+  if (tag && !equal(tok, '{'))
   {
     Type *ty = find_tag(tag);
     if (!ty) {
@@ -548,26 +956,25 @@ static Type *enum_specifier(Token **rest, Token *tok)
     return ty;
   }
 
-  tok = skip(tok, "{");
+  tok = skip(tok, '{');
 
   int i = 0;
   int val = 0;
-  while (!equal(tok, "}"))
+  while (!equal(tok, '}'))
   {
     if (i++ > 0) {
-      tok = skip(tok, ",");
+      tok = skip(tok, ',');
     }
 
-    char *name = get_ident(tok);
+    VarScope *sc = push_scope(tok);
     tok = tok->next;
 
-    if (equal(tok, "="))
+    if (equal(tok, '='))
     {
       val = get_number(tok->next);
       tok = tok->next->next;
     }
 
-    VarScope *sc = push_scope(name);
     sc->enum_ty = ty;
     sc->enum_val = val++;
   }
@@ -583,32 +990,70 @@ static Type *enum_specifier(Token **rest, Token *tok)
 // struct-members = (declspec declarator (","  declarator)* ";")*
 static void struct_members(Token **rest, Token *tok, Type *ty)
 {
-  Member head = {};
-  Member *cur = &head;
+  std::vector<Member> members;
 
-  while (!equal(tok, "}"))
+  while (!equal(tok, '}'))
   {
     Type *basety = declspec(&tok, tok, NULL);
     int i = 0;
 
-    while (!consume(&tok, tok, ";"))
+    while (!consume(&tok, tok, ';'))
     {
       if (i++)
-        tok = skip(tok, ",");
+        tok = skip(tok, ',');
 
-      Member *mem = (Member*)calloc(1, sizeof(Member));
-      mem->ty = declarator(&tok, tok, basety);
-      mem->name = mem->ty->name;
-      cur = cur->next = mem;
+      Member mem = {};
+      DeclName decl = {};
+      mem.ty = declarator(&tok, tok, basety, &decl);
+      mem.name = decl.name;
+      members.push_back(mem);
     }
   }
 
   *rest = tok->next;
-  ty->members = head.next;
+  int n = members.size();
+  Member *array = (Member*)calloc(n ? n : 1, sizeof(Member));
+  if (n)
+    memcpy(array, members.data(), n * sizeof(Member));
+  set_members(ty, array, n);
+}
+
+// assigns offsets within the struct to members
+static void struct_layout(Type *ty)
+{
+  int offset = 0;
+  for (Member *mem = ty->members; mem; mem = mem->next)
+  {
+    offset = align_to(offset, mem->ty->align);
+    mem->offset = offset;
+    offset += mem->ty->size;
+
+    if (ty->align < mem->ty->align)
+      ty->align = mem->ty->align;
+  }
+  ty->size = align_to(offset, ty->align);
+}
+
+static void union_layout(Type *ty)
+{
+  // we don't need to compute offsets of members in union
+  for (Member *mem = ty->members; mem; mem = mem->next)
+  {
+    if (ty->align < mem->ty->align)
+      ty->align = mem->ty->align;
+    if (ty->size < mem->ty->size)
+      ty->size = mem->ty->size;
+  }
+
+  ty->size = align_to(ty->size, ty->align);
 }
 
 // struct-union-decl -> ident? ("{" struct-members)?
-static Type *struct_union_decl(Token **rest, Token *tok)
+//
+// A struct or union is laid out when it's defined. A tag that refers to
+// it later yields the very same Type, which is never changed again, as
+// function bodies parsed in parallel may share it.
+static Type *struct_union_decl(Token **rest, Token *tok, TypeKind kind)
 {
   // read a tag
   Token *tag = NULL;
@@ -618,7 +1063,7 @@ static Type *struct_union_decl(Token **rest, Token *tok)
     tok = tok->next;
   }
 
-  if (tag && !equal(tok, "{"))
+  if (tag && !equal(tok, '{'))
   {
     Type *ty = find_tag(tag);
     if (!ty)
@@ -628,8 +1073,13 @@ static Type *struct_union_decl(Token **rest, Token *tok)
   }
 
   Type *ty = (Type*)calloc(1, sizeof(Type));
+  ty->kind = kind;
   struct_members(rest, tok->next, ty);
   ty->align = 1;
+  if (kind == TY_STRUCT)
+    struct_layout(ty);
+  else
+    union_layout(ty);
 
   // register the type if a name is given
   if (tag)
@@ -642,61 +1092,32 @@ static Type *struct_union_decl(Token **rest, Token *tok)
 // struct-decl -> struct-union-decl
 static Type *struct_decl(Token **rest, Token *tok)
 {
-  Type *ty = struct_union_decl(rest, tok);
-  ty->kind = TY_STRUCT;
-
-  // assign offsets within the struct to members.
-  int offset = 0;
-  for (Member *mem = ty->members; mem; mem = mem->next)
-  {
-    offset = align_to(offset, mem->ty->align);
-    mem->offset = offset;
-    offset += mem->ty->size;
-
-    if (ty->align < mem->ty->align)
-      ty->align = mem->ty->align;
-  }
-  ty->size = align_to(offset, ty->align);
-  return ty;
+  return struct_union_decl(rest, tok, TY_STRUCT);
 }
 
 // union-decl -> struct-union-decl
 static Type *union_decl(Token **rest, Token *tok)
 {
-  Type *ty = struct_union_decl(rest, tok);
-  ty->kind = TY_UNION;
-
-  // we don't need to compute offsets of members in union
-  for (Member *mem = ty->members; mem; mem = mem->next)
-  {
-    if (ty->align < mem->ty->align)
-      ty->align = mem->ty->align;
-    if (ty->size < mem->ty->size)
-      ty->size = mem->ty->size;
-  }
-
-  ty->size = align_to(ty->size, ty->align);
-  return ty;
+  return struct_union_decl(rest, tok, TY_UNION);
 }
 
 static Member *get_struct_member(Type *ty, Token *tok)
 {
-  for (Member *mem = ty->members; mem; mem = mem->next)
-  {
-    if (mem->name->len == tok->len && !strncmp(mem->name->loc, tok->loc, tok->len))
-      return mem;
-  }
-  error_tok(tok, "no such member");
+  Member *mem = find_member(ty, tok->sym);
+  if (!mem)
+    error_tok(tok, "no such member");
+  return mem;
 }
 
 static Node *struct_ref(Node *lhs, Token *tok)
 {
-  add_type(lhs);
   if (lhs->ty->kind != TY_STRUCT && lhs->ty->kind != TY_UNION)
     error_tok(lhs->tok, "not a struct or union");
 
-  Node *node = new_unary(ND_MEMBER, lhs, tok);
+  Node *node = new_node(ND_MEMBER, tok);
+  node->lhs = lhs;
   node->member = get_struct_member(lhs->ty, tok);
+  add_type(node);
   return node;
 }
 
@@ -707,27 +1128,28 @@ static Node *declaration(Token **rest, Token *tok, Type *basety)
   Node *cur = &head;
   int i = 0;
 
-  while (!equal(tok, ";"))
+  while (!equal(tok, ';'))
   {
     if (i++ > 0)
     {
-      tok = skip(tok, ",");
+      tok = skip(tok, ',');
     }
 
-    Type *ty = declarator(&tok, tok, basety);
+    DeclName decl = {};
+    Type *ty = declarator(&tok, tok, basety, &decl);
     if (ty->kind == TY_VOID)
     {
       error_tok(tok, "variable declared as void type");
     }
 
-    Obj *var = new_lvar(get_ident(ty->name), ty);
+    Obj *var = new_lvar(decl.name, ty);
 
-    if (!equal(tok, "="))
+    if (!equal(tok, '='))
     {
       continue;
     }
 
-    Node *lhs = new_var_node(var, ty->name);
+    Node *lhs = new_var_node(var, decl.name);
     Node *rhs = assign(&tok, tok->next);
     Node *node = new_binary(ND_ASSIGN, lhs, rhs, tok);
     cur = cur->next = new_unary(ND_EXPR_STMT, node, tok);
@@ -742,13 +1164,13 @@ static Node *declaration(Token **rest, Token *tok, Type *basety)
 // decides whether tok represents a type
 static bool is_typename(Token *tok)
 {
-  static char *kw[] = {
-      "void", "_Bool", "char", "short", "int", "long", "struct",
-      "union", "typedef", "enum", "static"};
-
-  for (int i = 0; i < sizeof(kw) / sizeof(*kw); i++)
-    if (equal(tok, kw[i]))
-      return true;
+  switch (tok->sym)
+  {
+  case KW_VOID: case KW_BOOL: case KW_CHAR: case KW_SHORT: case KW_INT:
+  case KW_LONG: case KW_STRUCT: case KW_UNION: case KW_TYPEDEF:
+  case KW_ENUM: case KW_STATIC:
+    return true;
+  }
   return find_typedef(tok);
 }
 
@@ -760,13 +1182,12 @@ static bool is_typename(Token *tok)
 //      | expr-stmt
 static Node *stmt(Token **rest, Token *tok)
 {
-  if (equal(tok, "return"))
+  if (equal(tok, KW_RETURN))
   {
     Node *node = new_node(ND_RETURN, tok);
     Node *exp = expr(&tok, tok->next);
-    *rest = skip(tok, ";");
+    *rest = skip(tok, ';');
 
-    add_type(exp);
     if (exp->ty->kind == current_fn->ty->return_ty->kind)
       node->lhs = exp; 
     else
@@ -774,23 +1195,23 @@ static Node *stmt(Token **rest, Token *tok)
     return node;
   }
 
-  if (equal(tok, "if"))
+  if (equal(tok, KW_IF))
   {
     Node *node = new_node(ND_IF, tok);
-    tok = skip(tok->next, "(");
+    tok = skip(tok->next, '(');
     node->cond = expr(&tok, tok);
-    tok = skip(tok, ")");
+    tok = skip(tok, ')');
     node->then = stmt(&tok, tok);
-    if (equal(tok, "else"))
+    if (equal(tok, KW_ELSE))
       node->els = stmt(&tok, tok->next);
     *rest = tok;
     return node;
   }
 
-  if (equal(tok, "for"))
+  if (equal(tok, KW_FOR))
   {
     Node *node = new_node(ND_FOR, tok);
-    tok = skip(tok->next, "(");
+    tok = skip(tok->next, '(');
 
     enter_scope();
 
@@ -802,30 +1223,30 @@ static Node *stmt(Token **rest, Token *tok)
       node->init = expr_stmt(&tok, tok);
     }
 
-    if (!equal(tok, ";"))
+    if (!equal(tok, ';'))
       node->cond = expr(&tok, tok);
-    tok = skip(tok, ";");
+    tok = skip(tok, ';');
 
-    if (!equal(tok, ")"))
+    if (!equal(tok, ')'))
       node->inc = expr(&tok, tok);
-    tok = skip(tok, ")");
+    tok = skip(tok, ')');
 
     node->then = stmt(rest, tok);
     leave_scope();
     return node;
   }
 
-  if (equal(tok, "while"))
+  if (equal(tok, KW_WHILE))
   {
     Node *node = new_node(ND_FOR, tok);
-    tok = skip(tok->next, "(");
+    tok = skip(tok->next, '(');
     node->cond = expr(&tok, tok);
-    tok = skip(tok, ")");
+    tok = skip(tok, ')');
     node->then = stmt(rest, tok);
     return node;
   }
 
-  if (equal(tok, "{"))
+  if (equal(tok, '{'))
     return compound_stmt(rest, tok->next);
 
   return expr_stmt(rest, tok);
@@ -840,7 +1261,7 @@ static Node *compound_stmt(Token **rest, Token *tok)
 
   enter_scope();
 
-  while (!equal(tok, "}"))
+  while (!equal(tok, '}'))
   {
     if (is_typename(tok))
     {
@@ -857,7 +1278,6 @@ static Node *compound_stmt(Token **rest, Token *tok)
     {
       cur = cur->next = stmt(&tok, tok);
     }
-    add_type(cur);
   }
 
   leave_scope();
@@ -869,7 +1289,7 @@ static Node *compound_stmt(Token **rest, Token *tok)
 // expr-stmt = expr? ";"
 static Node *expr_stmt(Token **rest, Token *tok)
 {
-  if (equal(tok, ";"))
+  if (equal(tok, ';'))
   {
     *rest = tok->next;
     return new_node(ND_BLOCK, tok);
@@ -877,7 +1297,7 @@ static Node *expr_stmt(Token **rest, Token *tok)
 
   Node *node = new_node(ND_EXPR_STMT, tok);
   node->lhs = expr(&tok, tok);
-  *rest = skip(tok, ";");
+  *rest = skip(tok, ';');
   return node;
 }
 
@@ -885,7 +1305,7 @@ static Node *expr_stmt(Token **rest, Token *tok)
 static Node *expr(Token **rest, Token *tok)
 {
   Node *node = assign(&tok, tok);
-  if (equal(tok, ","))
+  if (equal(tok, ','))
     return new_binary(ND_COMMA, node, expr(rest, tok->next), tok);
   *rest = tok;
   return node;
@@ -894,202 +1314,161 @@ static Node *expr(Token **rest, Token *tok)
 
 
 
-// Convert `A op= B` to `tmp = &A, *tmp = *tmp op B`
-// where tmp is a fresh pointer variable.
-static Node *to_assign(Node *binary) 
+// Convert `A op= B` to an ND_OP_ASSIGN of A and `old op B`, where old
+// is an ND_OLD_VALUE that loads A through the address the assignment
+// computes, so A is evaluated once and no temporary is needed.
+static Node *to_assign(NodeKind kind, Node *lhs, Node *rhs, Token *tok)
 {
-  add_type(binary->lhs);
-  add_type(binary->rhs);
-  Token* tok = binary->tok;
-
-  Obj* var = new_lvar("", pointer_to(binary->lhs->ty));    
+  // add_type() can't see A from here, so it's typed by hand
+  Node *val = new_node(ND_OLD_VALUE, tok);
+  val->ty = lhs->ty;
 
-  Node *expr1 = new_binary(ND_ASSIGN, new_var_node(var, tok), 
-                           new_unary(ND_ADDR, binary->lhs, tok), tok);
+  if (kind == ND_ADD)
+    val = new_add(val, rhs, tok);
+  else if (kind == ND_SUB)
+    val = new_sub(val, rhs, tok);
+  else
+    val = new_binary(kind, val, rhs, tok);
 
-  Node *expr2 = new_binary(ND_ASSIGN, new_unary(ND_DEREF, new_var_node(var, tok), tok),
-                           new_binary(binary->kind, new_unary(ND_DEREF, new_var_node(var, tok), tok),
-                                      binary->rhs, tok),
-                           tok);
-
-  return new_binary(ND_COMMA, expr1, expr2, tok);
+  return new_binary(ND_OP_ASSIGN, lhs, val, tok);
 }
 
 
 
-// assign    = logor (assign-op assign)?
-// assign-op = "=" | "+=" | "-=" | "*=" | "/=" | "%=" | "&=" | "|=" | "^="
-static Node *assign(Token **rest, Token *tok)
-{
-  Node *node = logor(&tok, tok);
-
-  if (equal(tok, "="))
-    return new_binary(ND_ASSIGN, node, assign(rest, tok->next), tok);
-
-  if (equal(tok, "+="))
-    return to_assign(new_add(node, assign(rest, tok->next), tok));
-
-  if (equal(tok, "-="))
-    return to_assign(new_sub(node, assign(rest, tok->next), tok));
-
-  if (equal(tok, "*="))
-    return to_assign(new_binary(ND_MUL, node, assign(rest, tok->next), tok));
-
-  if (equal(tok, "/="))
-    return to_assign(new_binary(ND_DIV, node, assign(rest, tok->next), tok));
-
-  if (equal(tok, "%="))
-    return to_assign(new_binary(ND_MOD, node, assign(rest, tok->next), tok));
-  
-  if (equal(tok, "&="))
-    return to_assign(new_binary(ND_BITAND, node, assign(rest, tok->next), tok));
-
-  if (equal(tok, "|="))
-    return to_assign(new_binary(ND_BITOR, node, assign(rest, tok->next), tok));
-
-  if (equal(tok, "^="))
-    return to_assign(new_binary(ND_BITXOR, node, assign(rest, tok->next), tok));
-
-  *rest = tok;
-  return node;
-}
-
+// Binary operators are parsed by precedence climbing rather than with
+// one function per precedence level, so an operand costs one call
+// whatever its precedence, and a flat chain of operators is a loop.
+//
+// assign    = binary(PREC_ASSIGN)
+// binary(p) = cast (op binary(q))*
+//
+// where each op binds at least as tightly as p, and q is the precedence
+// of op plus one for a left associative op, or that of op itself for a
+// right associative one. From loosest to tightest:
+//   "=" "+=" "-=" "*=" "/=" "%=" "&=" "|=" "^="  (right associative)
+//   "||"
+//   "&&"
+//   "|"
+//   "^"
+//   "&"
+//   "==" "!="
+//   "<" "<=" ">" ">="
+//   "+" "-"
+//   "*" "/" "%"
+enum
+{
+  PREC_NONE,
+  PREC_ASSIGN,
+  PREC_LOGOR,
+  PREC_LOGAND,
+  PREC_BITOR,
+  PREC_BITXOR,
+  PREC_BITAND,
+  PREC_EQUALITY,
+  PREC_RELATIONAL,
+  PREC_ADD,
+  PREC_MUL,
+};
 
-// logor = logand ("||" logand)*
-static Node *logor(Token **rest, Token *tok) 
+typedef struct
 {
-  Node *node = logand(&tok, tok);
-  while (equal(tok, "||"))
-  {
-    Token *start = tok;
-    node = new_binary(ND_LOGOR, node, logand(&tok, tok->next), start);
-  }
-  *rest = tok;
-  return node;
-}
-
+  uint8_t prec;  // PREC_NONE if the token isn't a binary operator
+  bool swap;     // `a > b` is built as `b < a`
+  bool compound; // `a op= b`, see to_assign()
+  NodeKind kind;
+} BinaryOp;
 
-// logand = bitor_ ("&&" bitor_)*
-static Node *logand(Token **rest, Token *tok) 
+// binary operators indexed by symbol id
+typedef struct
 {
-  Node *node = bitor_(&tok, tok);
-  while (equal(tok, "&&"))
-  {
-    Token *start = tok;
-    node = new_binary(ND_LOGAND, node, bitor_(&tok, tok->next), start);
-  }
-  *rest = tok;
-  return node;
-}
-
-
-// bitor_ = bitxor_ ("|" bitxor_)*
-static Node *bitor_(Token **rest, Token *tok) 
+  BinaryOp ops[SYM_IDENT];
+} BinaryOpTable;
+
+static constexpr BinaryOpTable make_binary_ops()
+{
+  BinaryOpTable t = {};
+  t.ops['='] = {PREC_ASSIGN, false, false, ND_ASSIGN};
+  t.ops[P_ADD_ASSIGN] = {PREC_ASSIGN, false, true, ND_ADD};
+  t.ops[P_SUB_ASSIGN] = {PREC_ASSIGN, false, true, ND_SUB};
+  t.ops[P_MUL_ASSIGN] = {PREC_ASSIGN, false, true, ND_MUL};
+  t.ops[P_DIV_ASSIGN] = {PREC_ASSIGN, false, true, ND_DIV};
+  t.ops[P_MOD_ASSIGN] = {PREC_ASSIGN, false, true, ND_MOD};
+  t.ops[P_AND_ASSIGN] = {PREC_ASSIGN, false, true, ND_BITAND};
+  t.ops[P_OR_ASSIGN] = {PREC_ASSIGN, false, true, ND_BITOR};
+  t.ops[P_XOR_ASSIGN] = {PREC_ASSIGN, false, true, ND_BITXOR};
+  t.ops[P_LOGOR] = {PREC_LOGOR, false, false, ND_LOGOR};
+  t.ops[P_LOGAND] = {PREC_LOGAND, false, false, ND_LOGAND};
+  t.ops['|'] = {PREC_BITOR, false, false, ND_BITOR};
+  t.ops['^'] = {PREC_BITXOR, false, false, ND_BITXOR};
+  t.ops['&'] = {PREC_BITAND, false, false, ND_BITAND};
+  t.ops[P_EQ] = {PREC_EQUALITY, false, false, ND_EQ};
+  t.ops[P_NE] = {PREC_EQUALITY, false, false, ND_NE};
+  t.ops['<'] = {PREC_RELATIONAL, false, false, ND_LT};
+  t.ops[P_LE] = {PREC_RELATIONAL, false, false, ND_LE};
+  t.ops['>'] = {PREC_RELATIONAL, true, false, ND_LT};
+  t.ops[P_GE] = {PREC_RELATIONAL, true, false, ND_LE};
+  t.ops['+'] = {PREC_ADD, false, false, ND_ADD};
+  t.ops['-'] = {PREC_ADD, false, false, ND_SUB};
+  t.ops['*'] = {PREC_MUL, false, false, ND_MUL};
+  t.ops['/'] = {PREC_MUL, false, false, ND_DIV};
+  t.ops['%'] = {PREC_MUL, false, false, ND_MOD};
+  return t;
+}
+
+static constexpr BinaryOpTable binary_ops = make_binary_ops();
+
+static const BinaryOp *binary_op(Token *tok)
+{
+  static const BinaryOp none = {};
+  return tok->sym < SYM_IDENT ? &binary_ops.ops[tok->sym] : &none;
+}
+
+static Node *new_binary_op(const BinaryOp *op, Node *lhs, Node *rhs, Token *tok)
+{
+  if (op->compound)
+    return to_assign(op->kind, lhs, rhs, tok);
+
+  Node *node;
+  if (op->kind == ND_ADD)
+    node = new_add(lhs, rhs, tok);
+  else if (op->kind == ND_SUB)
+    node = new_sub(lhs, rhs, tok);
+  else if (op->swap)
+    node = new_binary(op->kind, rhs, lhs, tok);
+  else
+    node = new_binary(op->kind, lhs, rhs, tok);
+  return fold(node);
+}
+
+// parses operators of precedence `prec` or tighter
+static Node *binary(Token **rest, Token *tok, int prec)
 {
-  Node *node = bitxor_(&tok, tok);
-  while (equal(tok, "|")) {
-    Token *start = tok;
-    node = new_binary(ND_BITOR, node, bitxor_(&tok, tok->next), start);
-  } 
-  *rest = tok;
-  return node;
-}
-
+  Node *node = cast(&tok, tok);
 
+  for (;;)
+  {
+    const BinaryOp *op = binary_op(tok);
+    if (op->prec < prec)
+      break;
 
-// bitxor_ = bitand_ ("^" bitand_)*
-static Node *bitxor_(Token **rest, Token *tok) {
-  Node *node = bitand_(&tok, tok);
-  while (equal(tok, "^")) {
     Token *start = tok;
-    node = new_binary(ND_BITXOR, node, bitand_(&tok, tok->next), start);
+    int next_prec = op->prec == PREC_ASSIGN ? PREC_ASSIGN : op->prec + 1;
+    Node *rhs = binary(&tok, tok->next, next_prec);
+    node = new_binary_op(op, node, rhs, start);
   }
-  *rest = tok;
-  return node;
-}
 
-// bitand_ = equality ("&" equality)*
-static Node *bitand_(Token **rest, Token *tok) {
-  Node *node = equality(&tok, tok);
-  while (equal(tok, "&")) {
-    Token *start = tok;
-    node = new_binary(ND_BITAND, node, equality(&tok, tok->next), start);
-  }
   *rest = tok;
   return node;
 }
 
-
-
-// equality = relational ("==" relational | "!=" relational)*
-static Node *equality(Token **rest, Token *tok)
+static Node *assign(Token **rest, Token *tok)
 {
-  Node *node = relational(&tok, tok);
-
-  for (;;)
-  {
-    Token *start = tok;
-
-    if (equal(tok, "=="))
-    {
-      node = new_binary(ND_EQ, node, relational(&tok, tok->next), start);
-      continue;
-    }
-
-    if (equal(tok, "!="))
-    {
-      node = new_binary(ND_NE, node, relational(&tok, tok->next), start);
-      continue;
-    }
-
-    *rest = tok;
-    return node;
-  }
+  return binary(rest, tok, PREC_ASSIGN);
 }
 
-// relational = add ("<" add | "<=" add | ">" add | ">=" add)*
-static Node *relational(Token **rest, Token *tok)
-{
-  Node *node = add(&tok, tok);
-
-  for (;;)
-  {
-    Token *start = tok;
-
-    if (equal(tok, "<"))
-    {
-      node = new_binary(ND_LT, node, add(&tok, tok->next), start);
-      continue;
-    }
-
-    if (equal(tok, "<="))
-    {
-      node = new_binary(ND_LE, node, add(&tok, tok->next), start);
-      continue;
-    }
-
-    if (equal(tok, ">"))
-    {
-      node = new_binary(ND_LT, add(&tok, tok->next), node, start);
-      continue;
-    }
-
-    if (equal(tok, ">="))
-    {
-      node = new_binary(ND_LE, add(&tok, tok->next), node, start);
-      continue;
-    }
-
-    *rest = tok;
-    return node;
-  }
-}
 
 static Node *new_add(Node *lhs, Node *rhs, Token *tok)
 {
-  add_type(lhs);
-  add_type(rhs);
-
   // num + num
   if (is_integer(lhs->ty) && is_integer(rhs->ty))
   {
@@ -1111,15 +1490,12 @@ static Node *new_add(Node *lhs, Node *rhs, Token *tok)
   }
 
   // ptr + num
-  rhs = new_binary(ND_MUL, rhs, new_long(lhs->ty->base->size, tok), tok);
+  rhs = fold(new_binary(ND_MUL, rhs, new_long(lhs->ty->base->size, tok), tok));
   return new_binary(ND_ADD, lhs, rhs, tok);
 }
 
 static Node *new_sub(Node *lhs, Node *rhs, Token *tok)
 {
-  add_type(lhs);
-  add_type(rhs);
-
   // num - num
   if (is_integer(lhs->ty) && is_integer(rhs->ty))
   {
@@ -1129,11 +1505,8 @@ static Node *new_sub(Node *lhs, Node *rhs, Token *tok)
   // ptr - num
   if (lhs->ty->base && is_integer(rhs->ty))
   {
-    rhs = new_binary(ND_MUL, rhs, new_long(lhs->ty->base->size, tok), tok);
-    add_type(rhs);
-    Node *node = new_binary(ND_SUB, lhs, rhs, tok);
-    node->ty = lhs->ty;
-    return node;
+    rhs = fold(new_binary(ND_MUL, rhs, new_long(lhs->ty->base->size, tok), tok));
+    return new_binary(ND_SUB, lhs, rhs, tok);
   }
 
   // ptr - ptr
@@ -1141,77 +1514,20 @@ static Node *new_sub(Node *lhs, Node *rhs, Token *tok)
   {
     Node *node = new_binary(ND_SUB, lhs, rhs, tok);
     node->ty = ty_int;
-    return new_binary(ND_DIV, node, new_num(lhs->ty->base->size, tok), tok);
+    return fold(new_binary(ND_DIV, node, new_num(lhs->ty->base->size, tok), tok));
   }
 
   error_tok(tok, "invalid operands");
 }
 
-// add = mul ("+" mul | "-" mul)*
-static Node *add(Token **rest, Token *tok)
-{
-  Node *node = mul(&tok, tok);
-
-  for (;;)
-  {
-    Token *start = tok;
-
-    if (equal(tok, "+"))
-    {
-      node = new_add(node, mul(&tok, tok->next), start);
-      continue;
-    }
-
-    if (equal(tok, "-"))
-    {
-      node = new_sub(node, mul(&tok, tok->next), start);
-      continue;
-    }
-
-    *rest = tok;
-    return node;
-  }
-}
-
-// mul = cast ("*" cast | "/" cast | "%" cast)*
-static Node *mul(Token **rest, Token *tok)
-{
-  Node *node = cast(&tok, tok);
-
-  for (;;)
-  {
-    Token *start = tok;
-
-    if (equal(tok, "*"))
-    {
-      node = new_binary(ND_MUL, node, cast(&tok, tok->next), start);
-      continue;
-    }
-
-    if (equal(tok, "/"))
-    {
-      node = new_binary(ND_DIV, node, cast(&tok, tok->next), start);
-      continue;
-    }
-
-    if (equal(tok, "%"))
-    {
-      node = new_binary(ND_MOD, node, cast(&tok, tok->next), start);
-    }
-
-    *rest = tok;
-    return node;
-  }
-}
-
 // cast -> "(" type-name ")" cast | unary
 static Node *cast(Token **rest, Token *tok)
 {
-  if (equal(tok, "(") && is_typename(tok->next))
+  if (equal(tok, '(') && is_typename(tok->next))
   {
     Token *start = tok;
     Type *ty = typename_(&tok, tok->next);
-    tok = skip(tok, ")");
+    tok = skip(tok, ')');
     Node *node = new_cast(cast(rest, tok), ty);
     node->tok = start;
     return node;
@@ -1225,32 +1541,32 @@ static Node *cast(Token **rest, Token *tok)
 //       | postfix
 static Node *unary(Token **rest, Token *tok)
 {
-  if (equal(tok, "+"))
+  if (equal(tok, '+'))
     return cast(rest, tok->next);
 
-  if (equal(tok, "-"))
-    return new_unary(ND_NEG, cast(rest, tok->next), tok);
+  if (equal(tok, '-'))
+    return fold(new_unary(ND_NEG, cast(rest, tok->next), tok));
 
-  if (equal(tok, "&"))
+  if (equal(tok, '&'))
     return new_unary(ND_ADDR, cast(rest, tok->next), tok);
 
-  if (equal(tok, "*"))
+  if (equal(tok, '*'))
     return new_unary(ND_DEREF, cast(rest, tok->next), tok);
 
-  if (equal(tok, "!")) 
-    return new_unary(ND_NOT, cast(rest, tok->next), tok);
+  if (equal(tok, '!')) 
+    return fold(new_unary(ND_NOT, cast(rest, tok->next), tok));
 
-  if (equal(tok, "~"))
-    return new_unary(ND_BITNOT, cast(rest, tok->next), tok);
+  if (equal(tok, '~'))
+    return fold(new_unary(ND_BITNOT, cast(rest, tok->next), tok));
 
 
   // treat ++i as i += 1
-  if (equal(tok, "++"))
-    return to_assign(new_add(unary(rest, tok->next), new_num(1, tok), tok));
+  if (equal(tok, P_INC))
+    return to_assign(ND_ADD, unary(rest, tok->next), new_num(1, tok), tok);
 
   // treat --i as i -= 1
-  if (equal(tok, "--"))
-    return to_assign(new_sub(unary(rest, tok->next), new_num(1, tok), tok));
+  if (equal(tok, P_DEC))
+    return to_assign(ND_SUB, unary(rest, tok->next), new_num(1, tok), tok);
 
   return postfix(rest, tok);
 }
@@ -1258,9 +1574,8 @@ static Node *unary(Token **rest, Token *tok)
 
 // Convert A++ to `(typeof A)((A += 1) - 1)`
 static Node *new_inc_dec(Node *node, Token *tok, int addend) {
-  add_type(node);
-  return new_cast(new_add(to_assign(new_add(node, new_num(addend, tok), tok)),
-                          new_num(-addend, tok), tok),
+  return new_cast(fold(new_add(to_assign(ND_ADD, node, new_num(addend, tok), tok),
+                               new_num(-addend, tok), tok)),
                   node->ty);
 }
 
@@ -1272,23 +1587,23 @@ static Node *postfix(Token **rest, Token *tok)
   Node *node = primary(&tok, tok);
   while (true)
   {
-    if (equal(tok, "["))
+    if (equal(tok, '['))
     {
       Token *start = tok;
       Node *idx = expr(&tok, tok->next);
-      tok = skip(tok, "]");
-      node = new_unary(ND_DEREF, new_add(node, idx, start), start);
+      tok = skip(tok, ']');
+      node = new_unary(ND_DEREF, fold(new_add(node, idx, start)), start);
       continue;
     }
 
-    if (equal(tok, "."))
+    if (equal(tok, '.'))
     {
       node = struct_ref(node, tok->next);
       tok = tok->next->next;
       continue;
     }
 
-    if (equal(tok, "->"))
+    if (equal(tok, P_ARROW))
     {
       node = new_unary(ND_DEREF, node, tok);
       node = struct_ref(node, tok->next);
@@ -1296,14 +1611,14 @@ static Node *postfix(Token **rest, Token *tok)
       continue;
     }
 
-    if (equal(tok, "++"))
+    if (equal(tok, P_INC))
     {
       node = new_inc_dec(node, tok, 1);
       tok = tok->next;
       continue;
     }
 
-    if (equal(tok, "--"))
+    if (equal(tok, P_DEC))
     {
       node = new_inc_dec(node, tok, -1);
       tok = tok->next;
@@ -1315,6 +1630,14 @@ static Node *postfix(Token **rest, Token *tok)
   }
 }
 
+// notes that the body being parsed refers to `var` if it's a function,
+// so that a lazy body of that name gets parsed too
+static void add_fn_ref(Token *tok, Obj *var)
+{
+  if (fn_refs && var->is_function)
+    fn_refs->push_back(tok->sym);
+}
+
 // funcall = ident "(" (assign ("," assign)*)? ")"
 static Node *funcall(Token **rest, Token *tok)
 {
@@ -1331,41 +1654,41 @@ static Node *funcall(Token **rest, Token *tok)
   {
     error_tok(start, "not a function");
   }
+  add_fn_ref(start, sc->var);
 
   Type *ty = sc->var->ty;
-  Type *param_ty = ty->params;
+  int nparams = 0;
 
   Node head = {};
   Node *cur = &head;
 
-  while (!equal(tok, ")"))
+  while (!equal(tok, ')'))
   {
     if (cur != &head)
-      tok = skip(tok, ",");
+      tok = skip(tok, ',');
 
     Node *arg = assign(&tok, tok);
-    add_type(arg);
 
-    if (param_ty)
+    if (nparams < ty->num_params)
     {
+      Type *param_ty = ty->params[nparams++];
       if (param_ty->kind == TY_STRUCT || param_ty->kind == TY_UNION)
         error_tok(arg->tok, "passing struct or union is not supported yet");
       
       if (arg->ty->kind != param_ty->kind)
         arg = new_cast(arg, param_ty);
-      param_ty = param_ty->next;
     }
 
     cur = cur->next = arg;
   }
 
-  *rest = skip(tok, ")");
+  *rest = skip(tok, ')');
 
   Node *node = new_node(ND_FUNCALL, start);
   node->funcname = strndup(start->loc, start->len);
   node->func_ty = ty;
-  node->ty = ty->return_ty;
   node->args = head.next;
+  add_type(node);
   return node;
 }
 
@@ -1380,40 +1703,40 @@ static Node *primary(Token **rest, Token *tok)
 {
   Token *start = tok;
 
-  if (equal(tok, "(") && equal(tok->next, "{"))
+  if (equal(tok, '(') && equal(tok->next, '{'))
   {
     // This is a GNU statement expresssion.
     Node *node = new_node(ND_STMT_EXPR, tok);
     node->body = compound_stmt(&tok, tok->next->next)->body;
-    *rest = skip(tok, ")");
+    *rest = skip(tok, ')');
+    add_type(node);
     return node;
   }
 
-  if (equal(tok, "("))
+  if (equal(tok, '('))
   {
     Node *node = expr(&tok, tok->next);
-    *rest = skip(tok, ")");
+    *rest = skip(tok, ')');
     return node;
   }
 
-  if (equal(tok, "sizeof") && equal(tok->next, "(") && is_typename(tok->next->next))
+  if (equal(tok, KW_SIZEOF) && equal(tok->next, '(') && is_typename(tok->next->next))
   {
     Type *ty = typename_(&tok, tok->next->next);
-    *rest = skip(tok, ")");
+    *rest = skip(tok, ')');
     return new_num(ty->size, start);
   }
 
-  if (equal(tok, "sizeof"))
+  if (equal(tok, KW_SIZEOF))
   {
     Node *node = unary(rest, tok->next);
-    add_type(node);
     return new_num(node->ty->size, tok);
   }
 
   if (tok->kind == TK_IDENT)
   {
     // function call
-    if (equal(tok->next, "("))
+    if (equal(tok->next, '('))
     {
       return funcall(rest, tok);
     }
@@ -1426,6 +1749,7 @@ static Node *primary(Token **rest, Token *tok)
     Node *node;
     if (sc->var)
     {
+      add_fn_ref(tok, sc->var);
       node = new_var_node(sc->var, tok);
     }
     else
@@ -1439,7 +1763,7 @@ static Node *primary(Token **rest, Token *tok)
 
   if (tok->kind == TK_STR)
   {
-    Obj *var = new_string_literal(tok->str, tok->ty);
+    Obj *var = new_string_literal(tok->str, array_of(ty_char, tok->str_len + 1));
     *rest = tok->next;
     return new_var_node(var, tok);
   }
@@ -1458,70 +1782,112 @@ static Token *parse_typedef(Token *tok, Type *basety)
 {
   bool first = true;
 
-  while (!consume(&tok, tok, ";"))
+  while (!consume(&tok, tok, ';'))
   {
     if (!first)
     {
-      tok = skip(tok, ",");
+      tok = skip(tok, ',');
     }
 
     first = false;
-    Type *ty = declarator(&tok, tok, basety);
-    push_scope(get_ident(ty->name))->type_def = ty;
+    DeclName decl = {};
+    Type *ty = declarator(&tok, tok, basety, &decl);
+    push_scope(decl.name)->type_def = ty;
   }
 
   return tok;
 }
 
-static void create_param_lvars(Type *param)
+static void create_param_lvars(Param *param)
 {
   if (param)
   {
     create_param_lvars(param->next);
-    new_lvar(get_ident(param->name), param);
+    new_lvar(param->name, param->ty);
   }
 }
 
-static Token *function(Token *tok, Type *basety, VarAttr *attr)
+static Token *function_body(Token *tok, Obj *fn, Param *params)
 {
-  Type *ty = declarator(&tok, tok, basety);
-
-  Obj *fn = new_gvar(get_ident(ty->name), ty);
-  fn->is_function = true;
-  fn->is_definition = !consume(&tok, tok, ";");
-  fn->is_static = attr->is_static;
-
-  if (!fn->is_definition)
-    return tok;
-
   current_fn = fn;
   locals = NULL;
   enter_scope();
-  create_param_lvars(ty->params);
+  create_param_lvars(params);
   fn->params = locals;
 
-  tok = skip(tok, "{");
+  tok = skip(tok, '{');
   fn->body = compound_stmt(&tok, tok);
   fn->locals = locals;
   leave_scope();
   return tok;
 }
 
+// the token after the braces that open at `tok`
+static Token *skip_braces(Token *tok)
+{
+  int depth = 0;
+  for (; tok->kind != TK_EOF; tok = tok->next)
+  {
+    if (equal(tok, '{'))
+      depth++;
+    else if (equal(tok, '}') && --depth == 0)
+      return tok->next;
+  }
+  return tok;
+}
+
+// the number of string literals between the braces that open at `tok`;
+// parsing the body would make an anonymous global for each of them
+static int count_literals(Token *tok)
+{
+  int n = 0;
+  for (Token *end = skip_braces(tok); tok != end; tok = tok->next)
+  {
+    if (tok->kind == TK_STR)
+      n++;
+  }
+  return n;
+}
+
+static Token *function(Token *tok, Type *basety, VarAttr *attr)
+{
+  DeclName decl = {};
+  Type *ty = declarator(&tok, tok, basety, &decl);
+
+  Obj *fn = new_gvar(decl.name, ty);
+  fn->is_function = true;
+  fn->is_definition = !consume(&tok, tok, ';');
+  fn->is_static = attr->is_static;
+
+  if (!fn->is_definition)
+    return tok;
+
+  if (deferred_bodies && equal(tok, '{'))
+  {
+    bool lazy = lazy_static && fn->is_static;
+    deferred_bodies->push_back({fn, decl.params, tok, num_file_bindings,
+                                decl.name->sym, lazy});
+    return skip_braces(tok);
+  }
+  return function_body(tok, fn, decl.params);
+}
+
 static Token *global_variable(Token *tok, Type *basety)
 {
   bool first = true;
 
-  while (!consume(&tok, tok, ";"))
+  while (!consume(&tok, tok, ';'))
   {
 
     if (!first)
     {
-      tok = skip(tok, ",");
+      tok = skip(tok, ',');
     }
     first = false;
 
-    Type *ty = declarator(&tok, tok, basety);
-    new_gvar(get_ident(ty->name), ty)->is_function = false;
+    DeclName decl = {};
+    Type *ty = declarator(&tok, tok, basety, &decl);
+    new_gvar(decl.name, ty)->is_function = false;
   }
 
   return tok;
@@ -1529,21 +1895,19 @@ static Token *global_variable(Token *tok, Type *basety)
 
 static bool is_function(Token *tok)
 {
-  if (equal(tok, ";"))
+  if (equal(tok, ';'))
   {
     return false;
   }
 
-  Type dummy = {};
-  Type *ty = declarator(&tok, tok, &dummy);
+  DeclName decl = {};
+  Type *ty = declarator(&tok, tok, ty_void, &decl);
   return ty->kind == TY_FUNC;
 }
 
 // program -> (typedef | function-definition | global-variable)*
-Obj *parse(Token *tok)
+static void program(Token *tok)
 {
-  globals = NULL;
-  globals_end = NULL;
   while (tok->kind != TK_EOF)
   {
     VarAttr attr = {};
@@ -1566,6 +1930,163 @@ Obj *parse(Token *tok)
     // gloval variable
     tok = global_variable(tok, basety);
   }
+}
+
+static void parse_deferred_body(DeferredBody *body, Arena *arena)
+{
+  Obj *saved_globals = globals;
+  Obj *saved_globals_end = globals_end;
+  globals = NULL;
+  globals_end = NULL;
+  cur_node_arena = arena;
+  visible_file_bindings = body->visible;
+  fn_refs = &body->refs;
+  defer_errors(true);
 
+  try
+  {
+    function_body(body->tok, body->fn, body->params);
+  }
+  catch (DeferredError &e)
+  {
+    body->error = e.msg;
+    while (scope != &file_scope)
+      leave_scope();
+  }
+
+  body->literals = globals;
+  globals = saved_globals;
+  globals_end = saved_globals_end;
+  cur_node_arena = &node_arena;
+  visible_file_bindings = INT_MAX;
+  fn_refs = NULL;
+}
+
+// Reads the file scope first, setting function bodies aside, then
+// parses the bodies on parse_jobs threads. A body sees the file scope
+// as it was where the body is, so the result is the same as that of
+// reading everything in order, errors included.
+//
+// With lazy_static, the body of a static function is parsed only once
+// a parsed body refers to it, starting from the bodies of the functions
+// other files can call. The others are left as declarations, so nothing
+// is generated for them and errors in them go unreported.
+static void parse_bodies(Token *tok)
+{
+  std::vector<DeferredBody> bodies;
+  char *error = NULL;
+
+  deferred_bodies = &bodies;
+  defer_errors(true);
+  try
+  {
+    program(tok);
+  }
+  catch (DeferredError &e)
+  {
+    error = e.msg;
+  }
+  deferred_bodies = NULL;
+
+  std::vector<DeferredBody *> todo;
+  for (DeferredBody &body : bodies)
+  {
+    if (!body.lazy)
+      todo.push_back(&body);
+  }
+
+  body_arenas.resize(parse_jobs);
+  std::unordered_set<int> referenced;
+  while (!todo.empty())
+  {
+    parallel_for_worker(todo.size(), parse_jobs, [&](int i, int worker) {
+      parse_deferred_body(todo[i], &body_arenas[worker]);
+    });
+
+    for (DeferredBody *body : todo)
+    {
+      body->parsed = true;
+      referenced.insert(body->refs.begin(), body->refs.end());
+    }
+
+    todo.clear();
+    for (DeferredBody &body : bodies)
+    {
+      if (!body.parsed && referenced.count(body.sym))
+        todo.push_back(&body);
+    }
+  }
+  defer_errors(false);
+
+  // stop at the first error in reading order
+  for (DeferredBody &body : bodies)
+  {
+    if (!body.parsed)
+    {
+      body.fn->is_definition = false;
+      skipped_literals[body.fn] = count_literals(body.tok);
+      continue;
+    }
+
+    if (body.error)
+    {
+      fputs(body.error, stderr);
+      exit(1);
+    }
+
+    // a body's globals come right after its function
+    if (body.literals)
+    {
+      Obj *last = body.literals;
+      while (last->next)
+        last = last->next;
+      last->next = body.fn->next;
+      body.fn->next = body.literals;
+    }
+  }
+
+  if (error)
+  {
+    fputs(error, stderr);
+    exit(1);
+  }
+}
+
+Obj *parse(Token *tok)
+{
+  globals = NULL;
+  globals_end = NULL;
+
+  if (parse_jobs > 1 || lazy_static)
+    parse_bodies(tok);
+  else
+    program(tok);
+
+  for (Obj *var = globals; var; var = var->next)
+  {
+    if (!var->name)
+      var->name = new_unique_name();
+
+    // later literals keep the names they'd have if the body was parsed
+    auto it = skipped_literals.find(var);
+    if (it != skipped_literals.end())
+      unique_id += it->second;
+  }
   return globals;
 }
+
+void set_parse_jobs(int n)
+{
+  parse_jobs = n;
+}
+
+void set_lazy_static(bool on)
+{
+  lazy_static = on;
+}
+
+void free_ast()
+{
+  node_arena.release();
+  body_arenas.clear();
+}
@@ -46,6 +46,8 @@ typedef enum
     ND_LT,     // <
     ND_LE,     // <=
     ND_ASSIGN, // =
+    ND_OP_ASSIGN, // A op= B, with rhs `old op B`
+    ND_OLD_VALUE, // old: the value A had, in the rhs of ND_OP_ASSIGN
     ND_COMMA,  // ,
     ND_MEMBER, // . (struct member access)
     ND_ADDR,   // unary &
@@ -70,40 +72,86 @@ typedef enum
 } NodeKind;
 
 
+// A node is allocated with room for the members its kind uses only,
+// so a member outside its kind's part of the union must not be touched.
 struct Node
 {
     NodeKind kind;
     Token *tok;
     Type *ty;
     Node *next;
-    Node *lhs;
-    Node *rhs;
 
-    // "if" or "for" statement
-    Node *cond;
-    Node *then;
-    Node *els;
-    Node *init;
-    Node *inc;
-
-    // block or statement expression
-    Node *body;
-
-    // struct member access
-    Member *member;
+    union {
+        // operators, casts, return and expression statements, and
+        // struct member access. rhs is used by binary operators only.
+        struct {
+            Node *lhs;
+            Node *rhs;
+            Member *member; // used if kind == ND_MEMBER
+        };
+
+        // "if" or "for" statement. init and inc are used by "for" only.
+        struct {
+            Node *cond;
+            Node *then;
+            Node *els;
+            Node *init;
+            Node *inc;
+        };
+
+        // block or statement expression
+        Node *body;
+
+        // function call
+        struct {
+            char *funcname;
+            Type *func_ty;
+            Node *args;
+        };
+
+        Obj *var;    // used if kind == ND_VAR
+        int64_t val; // used if kind == ND_NUM
+    };
+};
 
-    // function call
-    char *funcname;
-    Type *func_ty;
-    Node *args;
 
-    Obj *var;    // used if kind == ND_VAR
-    int64_t val; // used if kind == ND_NUM
-};
+// returns true if nodes of `kind` use both lhs and rhs
+inline bool is_binary(NodeKind kind)
+{
+    switch (kind)
+    {
+    case ND_ADD:
+    case ND_SUB:
+    case ND_MUL:
+    case ND_DIV:
+    case ND_MOD:
+    case ND_EQ:
+    case ND_NE:
+    case ND_LT:
+    case ND_LE:
+    case ND_ASSIGN:
+    case ND_OP_ASSIGN:
+    case ND_COMMA:
+    case ND_LOGAND:
+    case ND_LOGOR:
+    case ND_BITAND:
+    case ND_BITOR:
+    case ND_BITXOR:
+        return true;
+    default:
+        return false;
+    }
+}
 
 
 Node *new_cast(Node *expr, Type *ty);
 Obj *parse(Token *tok);
+// parse function bodies on up to n threads
+void set_parse_jobs(int n);
+// parse the body of a static function only if a parsed body refers to it
+void set_lazy_static(bool on);
+// frees every Node at once; nothing may refer to a node afterwards
+void free_ast();
 
 
 #endif /* PCC_PARSE_H */
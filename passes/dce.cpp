@@ -1,18 +1,19 @@
+#include <algorithm>
 #include <queue>
 #include "ir_core/Function.hpp"
 #include "ir_core/POTraversal.hpp"
 #include "ir_core/IRBuilder.hpp"
 #include "ir_core/Dominators.hpp"
+#include "ir_core/SlotMap.hpp"
+#include "utils/parallel.hpp"
 
 
-static std::unordered_map<BB*, std::vector<BB*>> 
+static BBMap<std::vector<BB*>> 
 calculate_rdf(Function* fn, const PostDominatorTree& tree)
 {
     using GT = InverseGraphTraits<Function>;
 
-    std::unordered_map<BB*, std::vector<BB*>> rdf;
-    for (auto bb = fn->begin(); bb != fn->end(); ++bb)
-        rdf[to_address(bb)] = {};
+    BBMap<std::vector<BB*>> rdf(fn);
 
     for (auto bb = fn->begin(); bb != fn->end(); ++bb)
     {
@@ -53,18 +54,17 @@ static bool is_critical(Inst* inst)
 }
 
 
-static void add_to_work_list(Value* val, std::unordered_set<Value*>& marked, std::queue<Value*>& work_list)
+static void add_to_work_list(Value* val, ValueSet& marked, std::queue<Value*>& work_list)
 {
-    if (marked.find(val) == marked.end()) {
-        marked.insert(val);
+    // constants and globals have nothing to mark
+    if (val->get_slot() != Value::no_slot && marked.insert(val))
         work_list.push(val);
-    }
 }
 
 
-static void mark(Value* val, std::unordered_set<Value*>& marked, 
-    std::queue<Value*>& work_list, const std::unordered_map<BB*, std::vector<BB*>>& rdf,
-    std::unordered_set<BB*>& useful_block)
+static void mark(Value* val, ValueSet& marked, 
+    std::queue<Value*>& work_list, const BBMap<std::vector<BB*>>& rdf,
+    BBSet& useful_block)
 {
     if (BinaryInst* binary_inst = dyn_cast<BinaryInst>(val)) {
         add_to_work_list(binary_inst->get_operand(0), marked, work_list);
@@ -111,7 +111,7 @@ static void mark(Value* val, std::unordered_set<Value*>& marked,
     }
 
     if (bb) {
-        for (BB* frontier: rdf.find(bb)->second) 
+        for (BB* frontier: rdf.lookup(bb)) 
             add_to_work_list(&frontier->back(), marked, work_list);
 
         useful_block.insert(bb);
@@ -119,11 +119,11 @@ static void mark(Value* val, std::unordered_set<Value*>& marked,
 }
 
 
-static std::pair<std::unordered_set<Value*>, std::unordered_set<BB*>> 
+static std::pair<ValueSet, BBSet> 
 mark(Function* fn, const PostDominatorTree& tree)
 {
-    std::unordered_set<Value*> marked;
-    std::unordered_set<BB*> useful_block;
+    ValueSet marked(fn);
+    BBSet useful_block(fn);
     std::queue<Value*> work_list;
 
     for (auto bb = fn->begin(); bb != fn->end(); ++bb) {
@@ -135,7 +135,7 @@ mark(Function* fn, const PostDominatorTree& tree)
         }
     }
 
-    std::unordered_map<BB*, std::vector<BB*>> rdf = calculate_rdf(fn, tree);
+    BBMap<std::vector<BB*>> rdf = calculate_rdf(fn, tree);
     while (!work_list.empty()) {
         mark(work_list.front(), marked, work_list, rdf, useful_block);
         work_list.pop();
@@ -146,10 +146,10 @@ mark(Function* fn, const PostDominatorTree& tree)
 
 
 static BB* find_marked_postdominator(BB* bb, 
-    const std::unordered_set<BB*>& useful_block, const PostDominatorTree& tree)
+    const BBSet& useful_block, const PostDominatorTree& tree)
 {
     auto target = tree.get_node(bb)->get_idom();
-    while (useful_block.find(target->get_block()) == useful_block.end()) {
+    while (!useful_block.contains(target->get_block())) {
         target = target->get_idom();
     }
 
@@ -157,21 +157,26 @@ static BB* find_marked_postdominator(BB* bb,
 }
 
 
-static void sweep(Function* fn, const std::unordered_set<Value*>& marked, 
-    const std::unordered_set<BB*>& useful_block, const PostDominatorTree& tree)
+static void sweep(Function* fn, const ValueSet& marked, 
+    const BBSet& useful_block, const PostDominatorTree& tree)
 {
     for (auto bb = fn->begin(); bb != fn->end(); ++bb) 
     {
         for (auto param = bb->param_begin(); param != bb->param_end(); ) 
         {
-            if (marked.find(to_address(param)) == marked.end()) {
+            if (!marked.contains(to_address(param))) {
+                // a branch with both arms to bb is listed once per arm
+                std::vector<BB*> preds;
                 for (auto&& pred: bb->predecessors()) {
-                    BrInst& br_inst = cast<BrInst>(pred.back());
-                    if (br_inst.get_successor(0) == to_address(bb)) {
-                        br_inst.remove_arg(0, param->get_index());
-                    }
-                    else {
-                        br_inst.remove_arg(1, param->get_index());
+                    if (std::find(preds.begin(), preds.end(), &pred) == preds.end())
+                        preds.push_back(&pred);
+                }
+
+                for (BB* pred: preds) {
+                    BrInst& br_inst = cast<BrInst>(pred->back());
+                    for (BrInst::op_size_type i = 0; i < br_inst.get_num_successors(); ++i) {
+                        if (br_inst.get_successor(i) == to_address(bb))
+                            br_inst.remove_arg(i, param->get_index());
                     }
                 }
                 
@@ -185,7 +190,7 @@ static void sweep(Function* fn, const std::unordered_set<Value*>& marked,
 
         for (auto inst = bb->begin(); inst != bb->end(); ) 
         {
-            if (marked.find(to_address(inst)) == marked.end()) {
+            if (!marked.contains(to_address(inst))) {
                 if (BrInst* br = dyn_cast<BrInst>(to_address(inst)); br && br->is_conditional()) {
                     BB* target = find_marked_postdominator(to_address(bb), useful_block, tree);
                     assert(target->param_size() == 0);
@@ -215,7 +220,7 @@ static bool is_redundant_cond_br(BrInst* br)
     if (br->get_num_args(0) != br->get_num_args(1))
         return false;
 
-    for (int i = 0; i < br->get_num_args(0); ++i)
+    for (BrInst::op_size_type i = 0; i < br->get_num_args(0); ++i)
         if (br->get_args(0)[i] != br->get_args(1)[i])
             return false;
 
@@ -228,7 +233,7 @@ static bool just_forwarding(BB* bb)
     BrInst* br = cast<BrInst>(&bb->back());
     if (br->is_unconditional())
     {
-        if (bb->param_size() != br->get_args(0).size())
+        if (bb->param_size() != br->get_num_args(0))
             return false;
 
         int n = bb->param_size();
@@ -296,7 +301,7 @@ static bool reduce_control_flow(BB* i)
                         last.set_successor(0, j);
                 }
 
-                for (int k = 0; k < i->param_size(); ++k)
+                for (size_t k = 0; k < i->param_size(); ++k)
                     i->get_params()[k].replace_all_uses_with(&j->get_params()[k]);
 
                 i->erase_from_parent();
@@ -323,7 +328,7 @@ static bool reduce_control_flow(BB* i)
         if (i && j->get_pred_num() == 1) 
         {
             auto args = jmp->get_args(0);
-            for (int k = 0; k < j->param_size(); ++k)
+            for (size_t k = 0; k < j->param_size(); ++k)
                 j->get_params()[k].replace_all_uses_with(args[k]);
             
             jmp->erase_from_parent();
@@ -401,6 +406,7 @@ static void reduce_control_flow(Function* fn)
 
 void dead_code_elimination(Function* fn)
 {
+    fn->renumber();
     PostDominatorTree tree(fn);
     auto [marked, useful_block] = mark(fn, tree);
     sweep(fn, marked, useful_block, tree);
@@ -408,8 +414,11 @@ void dead_code_elimination(Function* fn)
 }
 
 
-void dead_code_elimination(Module* module)
+void dead_code_elimination(Module* module, int jobs)
 {
+    std::vector<Function*> fns;
     for (auto fn = module->begin(); fn != module->end(); ++fn)
-        dead_code_elimination(to_address(fn));
+        fns.push_back(to_address(fn));
+
+    parallel_for(fns.size(), jobs, [&](int i) { dead_code_elimination(fns[i]); });
 }
\ No newline at end of file
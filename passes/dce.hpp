@@ -7,7 +7,13 @@ class Function;
 
 
 void dead_code_elimination(Function* fn);
-void dead_code_elimination(Module* module);
+
+/**
+ * @brief Removes the dead code of every function in \p module.
+ *
+ * @param jobs How many functions may be processed at once.
+ */
+void dead_code_elimination(Module* module, int jobs = 1);
 
 
 #endif /* PCC_PASSES_DCE_H */
@@ -1,4 +1,5 @@
 #include "ir_core/Module.hpp"
+#include "utils/parallel.hpp"
 #include "utils/util.hpp"
 #include "ir_core/Dominators.hpp"
 #include "gvn.hpp"
@@ -171,8 +172,11 @@ void global_value_numbering(Function* fn)
 }
 
 
-void global_value_numbering(Module* module)
+void global_value_numbering(Module* module, int jobs)
 {
+    std::vector<Function*> fns;
     for (auto fn = module->begin(); fn != module->end(); ++fn)
-        global_value_numbering(to_address(fn));
+        fns.push_back(to_address(fn));
+
+    parallel_for(fns.size(), jobs, [&](int i) { global_value_numbering(fns[i]); });
 }
\ No newline at end of file
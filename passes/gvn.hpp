@@ -6,7 +6,13 @@ class Function;
 class Module;
 
 void global_value_numbering(Function* fn);
-void global_value_numbering(Module* module);
+
+/**
+ * @brief Runs global value numbering on every function in \p module.
+ *
+ * @param jobs How many functions may be processed at once.
+ */
+void global_value_numbering(Module* module, int jobs = 1);
 
 
 #endif /* PCC_PASSES_GVN_H */
@@ -1,20 +1,36 @@
 #include <assert.h>
-#include <unordered_set>
-#include <unordered_map>
+#include <algorithm>
 #include <set>
 #include "mem2reg.hpp"
 #include "ir_core/Module.hpp"
+#include "ir_core/SlotMap.hpp"
+#include "utils/parallel.hpp"
 #include "utils/util.hpp"
 
 
-static std::unordered_map<BB*, std::unordered_map<AllocaInst*, Value*>> m2r;
-static std::unordered_map<Value*, Value*> r2r;
+// the promoted allocas are numbered in var_index, and a block's row of
+// m2r has an entry for each of them, sized on first use. The state is
+// per thread, so functions can be promoted concurrently.
+static thread_local ValueMap<int> var_index(-1);
+static thread_local std::vector<AllocaInst*> vars;
+static thread_local BBMap<std::vector<Value*>> m2r;
+static thread_local ValueMap<Value*> r2r;
 
-static std::unordered_map<BBParam*, AllocaInst*> param_to_var;
-static std::unordered_map<BBParam*, std::vector<Value*>> param_to_args;
-static std::vector<std::pair<BB*, BBParam*>> params_erased;
+static thread_local ValueMap<AllocaInst*> param_to_var;
+static thread_local ValueMap<std::vector<Value*>> param_to_args;
+static thread_local std::vector<std::pair<BB*, BBParam*>> params_erased;
 
-static std::unordered_set<BBParam*> visited;
+static thread_local ValueSet visited;
+
+
+// the value of var at the end of block so far, null if unknown
+static Value*& var_value(BB* block, AllocaInst* var)
+{
+    std::vector<Value*>& row = m2r[block];
+    if (row.empty())
+        row.resize(vars.size());
+    return row[var_index[var]];
+}
 
 
 static bool can_promote(const AllocaInst* ai)
@@ -35,30 +51,28 @@ static bool can_promote(const AllocaInst* ai)
 }
 
 
-static std::unordered_set<AllocaInst*> build_alloca_work_list(Function* fn)
+static void build_alloca_work_list(Function* fn)
 {
     BB& entry = fn->front();
-    std::unordered_set<AllocaInst*> alloca_work_list;
 
     for (auto&& inst = entry.begin(); inst != entry.end(); ++inst) {
         if (AllocaInst* ai = dyn_cast<AllocaInst>(to_address(inst))) {
             if (can_promote(ai)) {
-                alloca_work_list.insert(ai);
+                var_index[ai] = vars.size();
+                vars.push_back(ai);
             }
         }
     }
-
-    return alloca_work_list;
 }
 
 
-static AllocaInst* in_work_list(Value* val, const std::unordered_set<AllocaInst*>& alloca_work_list)
+static AllocaInst* in_work_list(Value* val)
 {
     AllocaInst* ai = dyn_cast<AllocaInst>(val);
     if (!ai) 
         return nullptr;
 
-    if (alloca_work_list.find(ai) == alloca_work_list.end())
+    if (var_index.lookup(ai) < 0)
         return nullptr;
 
     return ai;
@@ -67,36 +81,34 @@ static AllocaInst* in_work_list(Value* val, const std::unordered_set<AllocaInst*
 
 static Value* find_val_trivial(AllocaInst* var, BB* block) 
 {
-    auto iter = m2r[block].find(var);
-    if (iter != m2r[block].end()) {
-        assert(iter->second);
-        return iter->second;
-    }
+    if (Value* val = var_value(block, var))
+        return val;
 
     if (block->get_pred_num() == 1) {
-        m2r[block][var] = find_val_trivial(var, to_address(block->pred_begin()));
-        return m2r[block][var];
+        Value* val = find_val_trivial(var, to_address(block->pred_begin()));
+        var_value(block, var) = val;
+        return val;
     }
 
     BBParam* val = block->insert_param(var->get_type()->base);
-    m2r[block][var] = val;
+    var_value(block, var) = val;
     param_to_var[val] = var;
     return val;
 }
 
 
-static void set_map(Function* fn, const std::unordered_set<AllocaInst*>& alloca_work_list) 
+static void set_map(Function* fn) 
 {
     for (auto bb = fn->begin(); bb != fn->end(); ++bb)
     {
         for (auto ir = bb->begin(); ir != bb->end(); ++ir)
         {
             if (ir->get_kind() == ValueKind::INST_STORE) {
-                if (AllocaInst* ai = in_work_list(ir->get_operand(1), alloca_work_list))
-                    m2r[to_address(bb)][ai] = ir->get_operand(0);
+                if (AllocaInst* ai = in_work_list(ir->get_operand(1)))
+                    var_value(to_address(bb), ai) = ir->get_operand(0);
             }
             else if (ir->get_kind() == ValueKind::INST_LOAD) {
-                if (AllocaInst* ai = in_work_list(ir->get_operand(0), alloca_work_list)) {
+                if (AllocaInst* ai = in_work_list(ir->get_operand(0))) {
                     Value* val = find_val_trivial(ai, to_address(bb));
                     r2r[to_address(ir)] = val;
                 }
@@ -115,7 +127,7 @@ std::vector<Value*> get_pred_vals(BBParam* param)
     std::set<Value*> vals;
 
     for (auto&& pred: bb->predecessors()) {
-        Value* val = find_val(param_to_var[param], &pred);
+        Value* val = find_val(param_to_var.lookup(param), &pred);
         record.push_back(val);
         vals.insert(val);
     }
@@ -135,17 +147,16 @@ std::vector<Value*> get_pred_vals(BBParam* param)
 
 static Value* set_arg(BBParam* param)
 {
-    if (visited.find(param) != visited.end())
+    if (!visited.insert(param))
         return param;
 
     BB* block = param->get_parent();
-    visited.insert(param);
 
     std::vector<Value*> pred_vals = get_pred_vals(param);
     if (pred_vals.size() == 1) {
         Value* val = pred_vals[0];
         r2r[param] = val;
-        m2r[block][param_to_var[param]] = val;
+        var_value(block, param_to_var.lookup(param)) = val;
         assert(val != param);
         params_erased.emplace_back(block, param);
         return val;
@@ -159,8 +170,8 @@ static Value* set_arg(BBParam* param)
 static Value* map_to(Value* val)
 {
     Value* old = val;
-    while (r2r[val])
-        val = r2r[val];
+    while (Value* next = r2r.lookup(val))
+        val = next;
     
     if (val != old)
         r2r[old] = val;
@@ -170,22 +181,23 @@ static Value* map_to(Value* val)
 
 static Value* find_val(AllocaInst* var, BB* block) 
 {
-    if (auto iter = m2r[block].find(var); iter != m2r[block].end()) {
-        if (BBParam* param = dyn_cast<BBParam>(map_to(iter->second))) {
+    if (Value* val = var_value(block, var)) {
+        if (BBParam* param = dyn_cast<BBParam>(map_to(val))) {
             set_arg(param);
         }
-        return map_to(iter->second);
+        return map_to(var_value(block, var));
     }
 
     if (block->get_pred_num() == 1) {
-        m2r[block][var] = find_val(var, to_address(block->pred_begin()));
-        return m2r[block][var];
+        Value* val = find_val(var, to_address(block->pred_begin()));
+        var_value(block, var) = val;
+        return val;
     }
 
     BBParam* val = block->insert_param(var->get_type()->base);
-    m2r[block][var] = val;
+    var_value(block, var) = val;
     param_to_var[val] = var;
-    assert(r2r.count(val) == 0);
+    assert(!r2r.lookup(val));
     return set_arg(val);
 }
 
@@ -202,43 +214,55 @@ static void fill_args(Function* fn)
 {
     for (auto bb = fn->begin(); bb != fn->end(); ++bb)
     {
+        // adding an argument can move the branch's operands, and with them
+        // the uses the predecessor list is made of
+        std::vector<BB*> preds;
+        for (auto pred = bb->pred_begin(); pred != bb->pred_end(); ++pred)
+            preds.push_back(to_address(pred));
+
         for (auto param = bb->param_begin(); param != bb->param_end(); ++param)
         {
-            int i = 0;
+            // a parameter mapped to a value is erased after the rewrite
+            if (r2r.lookup(to_address(param)))
+                continue;
+
             std::vector<Value*>& args = param_to_args[to_address(param)];
-            for (auto pred = bb->pred_begin(); pred != bb->pred_end(); ++pred)
+            for (size_t i = 0; i < preds.size(); ++i)
             {
-                BrInst& last = cast<BrInst>(pred->back());
-                if (last.is_unconditional()) 
-                    last.add_arg(0, args[i]);
-                else if (last.get_successor(0) == to_address(bb)) 
-                    last.add_arg(0, args[i]);
-                else
-                    last.add_arg(1, args[i]);
-
-                ++i;
+                // a branch with both arms to bb is listed once per arm,
+                // and both arms get their argument the first time
+                if (std::find(preds.begin(), preds.begin() + i, preds[i]) != preds.begin() + i)
+                    continue;
+
+                BrInst& last = cast<BrInst>(preds[i]->back());
+                for (BrInst::op_size_type arm = 0; arm < last.get_num_successors(); ++arm) {
+                    if (last.get_successor(arm) == to_address(bb))
+                        last.add_arg(arm, args[i]);
+                }
             }
         }
     }
 }
 
 
-static void add_bb_args(Function* fn, const std::unordered_set<AllocaInst*>& work_list) 
+static void add_bb_args(Function* fn) 
 {
-    set_map(fn, work_list);
+    set_map(fn);
     set_args(fn);
-
-    for (auto&& p: params_erased) {
-        p.first->erase_param(p.second->get_index());
-    }
-
     fill_args(fn);
 }
 
 
-static void rewrite(Function* fn, const std::unordered_set<AllocaInst*>& work_list)
+static void rewrite()
 {
-    for (auto ai: work_list)
+    // resolve every load while all the values r2r goes through are alive:
+    // the value stored to one variable can be a load of another
+    for (auto ai: vars)
+        for (auto&& user: ai->get_users())
+            if (LoadInst* li = dyn_cast<LoadInst>(&user))
+                map_to(li);
+
+    for (auto ai: vars)
     {
         for (auto&& user = ai->user_begin(); user != ai->user_end(); )
         {
@@ -258,24 +282,38 @@ static void rewrite(Function* fn, const std::unordered_set<AllocaInst*>& work_li
 
         ai->erase_from_parent();
     }
+
+    for (auto&& p: params_erased) {
+        p.first->erase_param(p.second->get_index());
+    }
 }
 
 
-void mem2reg(Module* module)
+void mem2reg(Function* fn)
 {
-    for (auto fn = module->begin(); fn != module->end(); ++fn) 
-    {        
-        m2r.clear();
-        r2r.clear();
-        visited.clear();
-        param_to_var.clear();
-        param_to_args.clear();
-        params_erased.clear();
-        
-        std::unordered_set<AllocaInst*> work_list = build_alloca_work_list(to_address(fn));
-        add_bb_args(to_address(fn), work_list);  
-        rewrite(to_address(fn), work_list);       
-    }
+    fn->renumber();
+    var_index.reset(fn);
+    vars.clear();
+    m2r.reset(fn);
+    r2r.reset(fn);
+    visited.reset(fn);
+    param_to_var.reset(fn);
+    param_to_args.reset(fn);
+    params_erased.clear();
+    
+    build_alloca_work_list(fn);
+    add_bb_args(fn);  
+    rewrite();
+}
+
+
+void mem2reg(Module* module, int jobs)
+{
+    std::vector<Function*> fns;
+    for (auto fn = module->begin(); fn != module->end(); ++fn)
+        fns.push_back(to_address(fn));
+
+    parallel_for(fns.size(), jobs, [&](int i) { mem2reg(fns[i]); });
 }
 
 
@@ -2,9 +2,17 @@
 #define PCC_PASSES_MEM2REG_H
 
 
+class Function;
 class Module;
 
-void mem2reg(Module* module);
+void mem2reg(Function* fn);
+
+/**
+ * @brief Promotes the allocas of every function in \p module.
+ *
+ * @param jobs How many functions may be promoted at once.
+ */
+void mem2reg(Module* module, int jobs = 1);
 
 
 #endif /* PCC_PASSES_MEM2REG_H */
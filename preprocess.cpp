@@ -0,0 +1,1101 @@
+// This file implements the C preprocessor.
+//
+// The preprocessor takes the token list of the main input and returns
+// a new token list with every directive executed and every macro
+// expanded. It works on tokens only; source text is never rebuilt,
+// except for the few tokens made by '#' and '##'.
+//
+// Macros are expanded lazily, as the output list is built, using
+// Dave Prosser's hideset algorithm: every identifier carries the set of
+// macro names it was produced by, and a macro is never expanded inside
+// its own expansion.
+//
+// A header whose contents are wrapped in `#ifndef X / #define X ...
+// #endif` is remembered together with X, and later includes of it are
+// dropped without reading the file as long as X is defined. Headers
+// containing `#pragma once` are never included twice.
+
+#include <stdlib.h>
+#include <string.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "preprocess.hpp"
+#include "tokenize.hpp"
+#include "source.hpp"
+#include "token_cache.hpp"
+#include "utils/util.hpp"
+#include "utils/arena.hpp"
+
+
+struct MacroParam
+{
+    MacroParam *next;
+    int sym;
+};
+
+struct MacroArg
+{
+    MacroArg *next;
+    int sym;
+    Token *tok;
+    Token *expanded; // tok after macro expansion, made on first use
+};
+
+struct Macro
+{
+    bool is_objlike; // object-like or function-like
+    MacroParam *params;
+    Token *body;
+};
+
+// set of macro names, as a list of symbol ids
+struct Hideset
+{
+    Hideset *next;
+    int sym;
+};
+
+// `#if` can be nested, so we use a stack to manage nested `#if`s
+struct CondIncl
+{
+    CondIncl *next;
+    enum { IN_THEN, IN_ELIF, IN_ELSE } ctx;
+    Token *tok;
+    bool included;
+};
+
+
+// macros and hidesets live as long as the token lists that refer to them
+static Arena pp_arena;
+
+// macro definitions, indexed by the symbol id of their names
+static Macro **macros;
+static int macros_capacity;
+
+static CondIncl *cond_incl;
+
+static char **include_paths;
+static int num_include_paths;
+
+// guard macro of each header whose whole contents are an include guard
+static std::unordered_map<std::string, int> include_guards;
+
+// headers marked with `#pragma once`
+static std::unordered_set<std::string> pragma_once;
+
+// symbol ids of directive names. "if" and "else" are keywords.
+static int sym_include, sym_define, sym_undef, sym_ifdef, sym_ifndef,
+           sym_elif, sym_endif, sym_pragma, sym_error, sym_once, sym_defined;
+
+static Token *preprocess2(Token *tok);
+
+
+static bool is_hash(Token *tok)
+{
+    return tok->at_bol && equal(tok, '#');
+}
+
+// identifiers, keywords and punctuators carry a hideset. numbers and
+// string literals use the same storage for their values.
+static Hideset *get_hideset(Token *tok)
+{
+    if (tok->kind == TK_NUM || tok->kind == TK_STR || tok->kind == TK_EOF)
+        return nullptr;
+    return tok->hideset;
+}
+
+// some preprocessor directives such as #include allow extraneous
+// tokens before newline. this function skips such tokens.
+static Token *skip_line(Token *tok)
+{
+    while (!tok->at_bol && tok->kind != TK_EOF)
+        tok = tok->next;
+    return tok;
+}
+
+// copies all tokens until the next newline, terminates them with
+// an EOF token and then returns them.
+static Token *copy_line(Token **rest, Token *tok)
+{
+    Token head = {};
+    Token *cur = &head;
+
+    for (; !tok->at_bol && tok->kind != TK_EOF; tok = tok->next)
+        cur = cur->next = copy_token(tok);
+
+    cur->next = new_eof(tok);
+    *rest = tok;
+    return head.next;
+}
+
+static Token *copy_list(Token *tok)
+{
+    Token head = {};
+    Token *cur = &head;
+
+    for (; tok; tok = tok->next)
+        cur = cur->next = copy_token(tok);
+    return head.next;
+}
+
+static Token *new_num_token(int64_t val, Token *tmpl)
+{
+    Token *tok = copy_token(tmpl);
+    tok->kind = TK_NUM;
+    tok->sym = SYM_NONE;
+    tok->val = val;
+    return tok;
+}
+
+// links `tok2` after the last token of the fresh list `tok1`, dropping
+// tok1's EOF. unlike macro bodies, tok1 isn't shared, so no copy is made.
+static Token *append(Token *tok1, Token *tok2)
+{
+    if (tok1->kind == TK_EOF)
+        return tok2;
+
+    Token *t = tok1;
+    while (t->next->kind != TK_EOF)
+        t = t->next;
+    t->next = tok2;
+    return tok1;
+}
+
+
+//
+// Hidesets
+//
+
+static Hideset *new_hideset(int sym)
+{
+    Hideset *hs = pp_arena.alloc<Hideset>();
+    hs->sym = sym;
+    return hs;
+}
+
+static Hideset *hideset_union(Hideset *hs1, Hideset *hs2)
+{
+    Hideset head = {};
+    Hideset *cur = &head;
+
+    for (; hs1; hs1 = hs1->next)
+        cur = cur->next = new_hideset(hs1->sym);
+    cur->next = hs2;
+    return head.next;
+}
+
+static bool hideset_contains(Hideset *hs, int sym)
+{
+    for (; hs; hs = hs->next)
+        if (hs->sym == sym)
+            return true;
+    return false;
+}
+
+static Hideset *hideset_intersection(Hideset *hs1, Hideset *hs2)
+{
+    Hideset head = {};
+    Hideset *cur = &head;
+
+    for (; hs1; hs1 = hs1->next)
+        if (hideset_contains(hs2, hs1->sym))
+            cur = cur->next = new_hideset(hs1->sym);
+    return head.next;
+}
+
+// returns a copy of a token list with `hs` added to every hideset
+static Token *add_hideset(Token *tok, Hideset *hs)
+{
+    Token head = {};
+    Token *cur = &head;
+
+    for (; tok; tok = tok->next) {
+        Token *t = copy_token(tok);
+        if (t->kind != TK_NUM && t->kind != TK_STR && t->kind != TK_EOF)
+            t->hideset = hideset_union(t->hideset, hs);
+        cur = cur->next = t;
+    }
+    return head.next;
+}
+
+
+//
+// Macros
+//
+
+static Macro *find_macro(Token *tok)
+{
+    if (tok->kind != TK_IDENT && tok->kind != TK_KEYWORD)
+        return nullptr;
+    if (tok->sym >= macros_capacity)
+        return nullptr;
+    return macros[tok->sym];
+}
+
+static bool is_defined(int sym)
+{
+    return sym < macros_capacity && macros[sym];
+}
+
+static Macro *add_macro(int sym, bool is_objlike, Token *body)
+{
+    if (sym >= macros_capacity) {
+        int cap = macros_capacity ? macros_capacity : 1024;
+        while (cap <= sym)
+            cap *= 2;
+        macros = (Macro**)realloc(macros, sizeof(Macro*) * cap);
+        memset(macros + macros_capacity, 0,
+               sizeof(Macro*) * (cap - macros_capacity));
+        macros_capacity = cap;
+    }
+
+    Macro *m = pp_arena.alloc<Macro>();
+    m->is_objlike = is_objlike;
+    m->body = body;
+    macros[sym] = m;
+    return m;
+}
+
+static void undef_macro(int sym)
+{
+    if (sym < macros_capacity)
+        macros[sym] = nullptr;
+}
+
+static bool is_macro_name(Token *tok)
+{
+    return tok->kind == TK_IDENT || tok->kind == TK_KEYWORD;
+}
+
+static MacroParam *read_macro_params(Token **rest, Token *tok)
+{
+    MacroParam head = {};
+    MacroParam *cur = &head;
+
+    while (!equal(tok, ')')) {
+        if (cur != &head)
+            tok = skip(tok, ',');
+
+        if (!is_macro_name(tok))
+            error_tok(tok, "expected an identifier");
+        MacroParam *m = pp_arena.alloc<MacroParam>();
+        m->sym = tok->sym;
+        cur = cur->next = m;
+        tok = tok->next;
+    }
+
+    *rest = tok->next;
+    return head.next;
+}
+
+static void read_macro_definition(Token **rest, Token *tok)
+{
+    if (!is_macro_name(tok))
+        error_tok(tok, "macro name must be an identifier");
+    int name = tok->sym;
+    tok = tok->next;
+
+    if (!tok->has_space && equal(tok, '(')) {
+        // function-like macro
+        MacroParam *params = read_macro_params(&tok, tok->next);
+        Macro *m = add_macro(name, false, copy_line(rest, tok));
+        m->params = params;
+    }
+    else {
+        // object-like macro
+        add_macro(name, true, copy_line(rest, tok));
+    }
+}
+
+static MacroArg *read_macro_arg_one(Token **rest, Token *tok)
+{
+    Token head = {};
+    Token *cur = &head;
+    int level = 0;
+
+    while (level > 0 || (!equal(tok, ',') && !equal(tok, ')'))) {
+        if (tok->kind == TK_EOF)
+            error_tok(tok, "premature end of input");
+
+        if (equal(tok, '('))
+            level++;
+        else if (equal(tok, ')'))
+            level--;
+
+        cur = cur->next = copy_token(tok);
+        tok = tok->next;
+    }
+
+    cur->next = new_eof(tok);
+
+    MacroArg *arg = pp_arena.alloc<MacroArg>();
+    arg->tok = head.next;
+    *rest = tok;
+    return arg;
+}
+
+static MacroArg *read_macro_args(Token **rest, Token *tok, MacroParam *params)
+{
+    Token *start = tok;
+    tok = tok->next->next;
+
+    MacroArg head = {};
+    MacroArg *cur = &head;
+
+    MacroParam *pp = params;
+    for (; pp; pp = pp->next) {
+        if (cur != &head)
+            tok = skip(tok, ',');
+        cur = cur->next = read_macro_arg_one(&tok, tok);
+        cur->sym = pp->sym;
+    }
+
+    if (pp)
+        error_tok(start, "too few arguments");
+    if (!equal(tok, ')'))
+        error_tok(tok, "too many arguments");
+    *rest = tok;
+    return head.next;
+}
+
+static MacroArg *find_arg(MacroArg *args, Token *tok)
+{
+    if (!is_macro_name(tok))
+        return nullptr;
+    for (MacroArg *ap = args; ap; ap = ap->next)
+        if (tok->sym == ap->sym)
+            return ap;
+    return nullptr;
+}
+
+// concatenates all tokens in `tok` and returns a new string
+static char *join_tokens(Token *tok, Token *end)
+{
+    // compute the length of the resulting token
+    int len = 1;
+    for (Token *t = tok; t != end && t->kind != TK_EOF; t = t->next) {
+        if (t != tok && t->has_space)
+            len++;
+        len += t->len;
+    }
+
+    char *buf = (char*)calloc(1, len);
+
+    // copy token texts
+    int pos = 0;
+    for (Token *t = tok; t != end && t->kind != TK_EOF; t = t->next) {
+        if (t != tok && t->has_space)
+            buf[pos++] = ' ';
+        memcpy(buf + pos, t->loc, t->len);
+        pos += t->len;
+    }
+    buf[pos] = '\0';
+    return buf;
+}
+
+// tokenizes text made by the preprocessor. the text is registered as
+// a buffer of the file `tmpl` came from, so diagnostics still work.
+static Token *tokenize_text(char *text, Token *tmpl)
+{
+    SourceFile *origin = find_source_file(tmpl->loc);
+    SourceFile *file = new_source_file(origin->name, origin->file_no,
+                                       text, strlen(text));
+    Token *tok = tokenize(file);
+    tok->at_bol = false;
+    tok->has_space = tmpl->has_space;
+    return tok;
+}
+
+// double-quotes a given string and returns it
+static char *quote_string(char *str)
+{
+    int bufsize = 3;
+    for (int i = 0; str[i]; i++) {
+        if (str[i] == '\\' || str[i] == '"')
+            bufsize++;
+        bufsize++;
+    }
+
+    char *buf = (char*)calloc(1, bufsize);
+
+    int pos = 0;
+    buf[pos++] = '"';
+    for (int i = 0; str[i]; i++) {
+        if (str[i] == '\\' || str[i] == '"')
+            buf[pos++] = '\\';
+        buf[pos++] = str[i];
+    }
+    buf[pos++] = '"';
+    buf[pos++] = '\0';
+    return buf;
+}
+
+// concatenates all tokens in `arg` and returns a new string token.
+// this function is used for the stringizing operator (#).
+static Token *stringize(Token *hash, Token *arg)
+{
+    return tokenize_text(quote_string(join_tokens(arg, nullptr)), hash);
+}
+
+// concatenates two tokens to create a new token
+static Token *paste(Token *lhs, Token *rhs)
+{
+    char *buf = format("%.*s%.*s", lhs->len, lhs->loc, rhs->len, rhs->loc);
+    Token *tok = tokenize_text(buf, lhs);
+    if (tok->next->kind != TK_EOF)
+        error_tok(lhs, "pasting forms '%s', an invalid token", buf);
+    return tok;
+}
+
+// replaces func-like macro parameters with given arguments
+static Token *subst(Token *tok, MacroArg *args)
+{
+    Token head = {};
+    Token *cur = &head;
+
+    while (tok->kind != TK_EOF) {
+        // "#" followed by a parameter is replaced with stringized actuals
+        if (equal(tok, '#')) {
+            MacroArg *arg = find_arg(args, tok->next);
+            if (!arg)
+                error_tok(tok->next, "'#' is not followed by a macro parameter");
+            cur = cur->next = stringize(tok, arg->tok);
+            tok = tok->next->next;
+            continue;
+        }
+
+        if (equal(tok, P_HASHHASH)) {
+            if (cur == &head)
+                error_tok(tok, "'##' cannot appear at start of macro expansion");
+            if (tok->next->kind == TK_EOF)
+                error_tok(tok, "'##' cannot appear at end of macro expansion");
+
+            MacroArg *arg = find_arg(args, tok->next);
+            if (arg) {
+                if (arg->tok->kind != TK_EOF) {
+                    *cur = *paste(cur, arg->tok);
+                    for (Token *t = arg->tok->next; t->kind != TK_EOF; t = t->next)
+                        cur = cur->next = copy_token(t);
+                }
+                tok = tok->next->next;
+                continue;
+            }
+
+            *cur = *paste(cur, tok->next);
+            tok = tok->next->next;
+            continue;
+        }
+
+        MacroArg *arg = find_arg(args, tok);
+
+        if (arg && equal(tok->next, P_HASHHASH)) {
+            Token *rhs = tok->next->next;
+
+            if (arg->tok->kind == TK_EOF) {
+                MacroArg *arg2 = find_arg(args, rhs);
+                if (arg2) {
+                    for (Token *t = arg2->tok; t->kind != TK_EOF; t = t->next)
+                        cur = cur->next = copy_token(t);
+                }
+                else {
+                    cur = cur->next = copy_token(rhs);
+                }
+                tok = rhs->next;
+                continue;
+            }
+
+            for (Token *t = arg->tok; t->kind != TK_EOF; t = t->next)
+                cur = cur->next = copy_token(t);
+            tok = tok->next;
+            continue;
+        }
+
+        // macro arguments are completely macro-expanded before they
+        // are substituted into a macro body. expansion relinks the list
+        // it works on, so it runs on a copy: `#` and `##` need the
+        // argument as written.
+        if (arg) {
+            if (!arg->expanded)
+                arg->expanded = preprocess2(copy_list(arg->tok));
+            Token *t = arg->expanded;
+            t->at_bol = tok->at_bol;
+            t->has_space = tok->has_space;
+            for (; t->kind != TK_EOF; t = t->next)
+                cur = cur->next = copy_token(t);
+            tok = tok->next;
+            continue;
+        }
+
+        cur = cur->next = copy_token(tok);
+        tok = tok->next;
+    }
+
+    cur->next = tok;
+    return head.next;
+}
+
+// if tok is a macro, expands it and returns true.
+// otherwise, does nothing and returns false.
+static bool expand_macro(Token **rest, Token *tok)
+{
+    Macro *m = find_macro(tok);
+    if (!m || hideset_contains(tok->hideset, tok->sym))
+        return false;
+
+    // object-like macro application
+    if (m->is_objlike) {
+        Hideset *hs = hideset_union(tok->hideset, new_hideset(tok->sym));
+        Token *body = add_hideset(m->body, hs);
+        *rest = append(body, tok->next);
+        (*rest)->at_bol = tok->at_bol;
+        (*rest)->has_space = tok->has_space;
+        return true;
+    }
+
+    // if a funclike macro token is not followed by an argument list,
+    // treat it as a normal identifier
+    if (!equal(tok->next, '('))
+        return false;
+
+    // function-like macro application
+    Token *macro_token = tok;
+    MacroArg *args = read_macro_args(&tok, tok, m->params);
+    Token *rparen = tok;
+
+    // tokens that consist a func-like macro invocation may have different
+    // hidesets, and if that's the case, it's not clear what the hideset
+    // for the new tokens should be. we take the interesection of the
+    // macro token and the closing parenthesis and use it as a new hideset
+    // as explained in the Dave Prosser's algorithm.
+    Hideset *hs = hideset_intersection(macro_token->hideset, get_hideset(rparen));
+    hs = hideset_union(hs, new_hideset(macro_token->sym));
+
+    Token *body = subst(m->body, args);
+    body = add_hideset(body, hs);
+    *rest = append(body, tok->next);
+    (*rest)->at_bol = macro_token->at_bol;
+    (*rest)->has_space = macro_token->has_space;
+    return true;
+}
+
+
+//
+// Conditional inclusion
+//
+
+// skips until next `#endif`. nested `#if` and `#endif` are skipped.
+static Token *skip_cond_incl2(Token *tok)
+{
+    while (tok->kind != TK_EOF) {
+        if (is_hash(tok) &&
+            (equal(tok->next, KW_IF) || equal(tok->next, sym_ifdef) ||
+             equal(tok->next, sym_ifndef))) {
+            tok = skip_cond_incl2(tok->next->next);
+            continue;
+        }
+        if (is_hash(tok) && equal(tok->next, sym_endif))
+            return tok->next->next;
+        tok = tok->next;
+    }
+    return tok;
+}
+
+// skips until next `#else`, `#elif` or `#endif`.
+// nested `#if` and `#endif` are skipped.
+static Token *skip_cond_incl(Token *tok)
+{
+    while (tok->kind != TK_EOF) {
+        if (is_hash(tok) &&
+            (equal(tok->next, KW_IF) || equal(tok->next, sym_ifdef) ||
+             equal(tok->next, sym_ifndef))) {
+            tok = skip_cond_incl2(tok->next->next);
+            continue;
+        }
+
+        if (is_hash(tok) &&
+            (equal(tok->next, sym_elif) || equal(tok->next, KW_ELSE) ||
+             equal(tok->next, sym_endif)))
+            break;
+        tok = tok->next;
+    }
+    return tok;
+}
+
+static CondIncl *push_cond_incl(Token *tok, bool included)
+{
+    CondIncl *ci = pp_arena.alloc<CondIncl>();
+    ci->next = cond_incl;
+    ci->ctx = CondIncl::IN_THEN;
+    ci->tok = tok;
+    ci->included = included;
+    cond_incl = ci;
+    return ci;
+}
+
+
+// #if expressions are evaluated directly on tokens, in intmax_t.
+// Operands skipped by &&, || and ?: are parsed with `eval` false:
+// their value is meaningless and they can't fail, so `0 && 1/0` is fine.
+static int64_t eval_cond(Token **rest, Token *tok, bool eval);
+
+static int64_t eval_primary(Token **rest, Token *tok, bool eval)
+{
+    if (equal(tok, '(')) {
+        int64_t val = eval_cond(&tok, tok->next, eval);
+        *rest = skip(tok, ')');
+        return val;
+    }
+
+    if (equal(tok, '+'))
+        return eval_primary(rest, tok->next, eval);
+    if (equal(tok, '-'))
+        return -eval_primary(rest, tok->next, eval);
+    if (equal(tok, '!'))
+        return !eval_primary(rest, tok->next, eval);
+    if (equal(tok, '~'))
+        return ~eval_primary(rest, tok->next, eval);
+
+    if (tok->kind != TK_NUM)
+        error_tok(tok, "invalid expression");
+    *rest = tok->next;
+    return tok->val;
+}
+
+// binding power of a binary operator, or 0 if tok isn't one
+static int eval_prec(Token *tok)
+{
+    switch (tok->sym) {
+    case P_LOGOR: return 1;
+    case P_LOGAND: return 2;
+    case '|': return 3;
+    case '^': return 4;
+    case '&': return 5;
+    case P_EQ: case P_NE: return 6;
+    case '<': case '>': case P_LE: case P_GE: return 7;
+    case '+': case '-': return 8;
+    case '*': case '/': case '%': return 9;
+    }
+    return 0;
+}
+
+static int64_t eval_binary(Token **rest, Token *tok, int min_prec, bool eval)
+{
+    int64_t lhs = eval_primary(&tok, tok, eval);
+
+    for (int prec; (prec = eval_prec(tok)) >= min_prec;) {
+        Token *op = tok;
+        bool eval_rhs = eval;
+        if (op->sym == P_LOGOR)
+            eval_rhs = eval && !lhs;
+        else if (op->sym == P_LOGAND)
+            eval_rhs = eval && lhs;
+
+        int64_t rhs = eval_binary(&tok, tok->next, prec + 1, eval_rhs);
+        if (!eval)
+            continue;
+
+        switch (op->sym) {
+        case P_LOGOR: lhs = lhs || (eval_rhs && rhs); break;
+        case P_LOGAND: lhs = lhs && (eval_rhs && rhs); break;
+        case '|': lhs |= rhs; break;
+        case '^': lhs ^= rhs; break;
+        case '&': lhs &= rhs; break;
+        case P_EQ: lhs = lhs == rhs; break;
+        case P_NE: lhs = lhs != rhs; break;
+        case '<': lhs = lhs < rhs; break;
+        case '>': lhs = lhs > rhs; break;
+        case P_LE: lhs = lhs <= rhs; break;
+        case P_GE: lhs = lhs >= rhs; break;
+        case '+': lhs += rhs; break;
+        case '-': lhs -= rhs; break;
+        case '*': lhs *= rhs; break;
+        case '/':
+        case '%':
+            if (rhs == 0)
+                error_tok(op, "division by zero");
+            lhs = op->sym == '/' ? lhs / rhs : lhs % rhs;
+            break;
+        }
+    }
+
+    *rest = tok;
+    return lhs;
+}
+
+// cond = binary ("?" cond ":" cond)?
+static int64_t eval_cond(Token **rest, Token *tok, bool eval)
+{
+    int64_t cond = eval_binary(&tok, tok, 1, eval);
+    if (!equal(tok, '?')) {
+        *rest = tok;
+        return cond;
+    }
+
+    int64_t then = eval_cond(&tok, tok->next, eval && cond);
+    tok = skip(tok, ':');
+    int64_t els = eval_cond(rest, tok, eval && !cond);
+    return cond ? then : els;
+}
+
+// reads a constant expression following #if or #elif
+static Token *read_const_expr(Token **rest, Token *tok)
+{
+    tok = copy_line(rest, tok);
+
+    Token head = {};
+    Token *cur = &head;
+
+    while (tok->kind != TK_EOF) {
+        // "defined(foo)" or "defined foo" becomes 1 if macro "foo"
+        // is defined. otherwise 0.
+        if (equal(tok, sym_defined)) {
+            Token *start = tok;
+            bool has_paren = consume(&tok, tok->next, '(');
+
+            if (!is_macro_name(tok))
+                error_tok(start, "macro name must be an identifier");
+            bool defined = find_macro(tok);
+            tok = tok->next;
+
+            if (has_paren)
+                tok = skip(tok, ')');
+
+            cur = cur->next = new_num_token(defined, start);
+            continue;
+        }
+
+        cur = cur->next = tok;
+        tok = tok->next;
+    }
+
+    cur->next = tok;
+    return head.next;
+}
+
+// reads and evaluates a constant expression
+static int64_t eval_const_expr(Token **rest, Token *tok)
+{
+    Token *start = tok;
+    Token *expr = read_const_expr(rest, tok->next);
+    expr = preprocess2(expr);
+
+    if (expr->kind == TK_EOF)
+        error_tok(start, "no expression");
+
+    // the standard requires we replace remaining non-macro identifiers
+    // with "0" before evaluating a constant expression. for example,
+    // `#if foo` is equivalent to `#if 0` if foo is not defined.
+    for (Token *t = expr; t->kind != TK_EOF; t = t->next) {
+        if (is_macro_name(t)) {
+            Token *next = t->next;
+            *t = *new_num_token(0, t);
+            t->next = next;
+        }
+    }
+
+    int64_t val = eval_cond(&tok, expr, true);
+    if (tok->kind != TK_EOF)
+        error_tok(tok, "extra token");
+    return val;
+}
+
+
+//
+// Includes
+//
+
+static bool file_exists(char *path)
+{
+    struct stat st;
+    return !stat(path, &st);
+}
+
+static char *search_include_paths(char *filename)
+{
+    if (filename[0] == '/')
+        return filename;
+
+    for (int i = 0; i < num_include_paths; i++) {
+        char *path = format("%s/%s", include_paths[i], filename);
+        if (file_exists(path))
+            return path;
+        free(path);
+    }
+    return nullptr;
+}
+
+// reads an #include argument
+static char *read_include_filename(Token **rest, Token *tok, bool *is_dquote)
+{
+    // pattern 1: #include "foo.h"
+    if (tok->kind == TK_STR) {
+        // a double-quoted filename for #include is a special kind of
+        // token, and we don't want to interpret any escape sequences in it
+        *is_dquote = true;
+        *rest = skip_line(tok->next);
+        return strndup(tok->loc + 1, tok->len - 2);
+    }
+
+    // pattern 2: #include <foo.h>
+    if (equal(tok, '<')) {
+        // reconstruct a filename from a sequence of tokens between
+        // "<" and ">"
+        Token *start = tok;
+
+        // find closing ">"
+        for (; !equal(tok, '>'); tok = tok->next)
+            if (tok->at_bol || tok->kind == TK_EOF)
+                error_tok(tok, "expected '>'");
+
+        *is_dquote = false;
+        *rest = skip_line(tok->next);
+        return join_tokens(start->next, tok);
+    }
+
+    error_tok(tok, "expected a filename");
+}
+
+// detects the following "include guard" pattern
+//
+//   #ifndef FOO_H
+//   #define FOO_H
+//   ...
+//   #endif
+//
+// and returns the symbol id of the guard macro, or SYM_NONE
+static int detect_include_guard(Token *tok)
+{
+    // detect the first two lines
+    if (!is_hash(tok) || !equal(tok->next, sym_ifndef))
+        return SYM_NONE;
+    tok = tok->next->next;
+
+    if (tok->kind != TK_IDENT)
+        return SYM_NONE;
+    int guard = tok->sym;
+    tok = tok->next;
+
+    if (!is_hash(tok) || !equal(tok->next, sym_define) ||
+        !equal(tok->next->next, guard))
+        return SYM_NONE;
+
+    // read until the end of the file
+    while (tok->kind != TK_EOF) {
+        if (!is_hash(tok)) {
+            tok = tok->next;
+            continue;
+        }
+
+        if (equal(tok->next, sym_endif) && tok->next->next->kind == TK_EOF)
+            return guard;
+
+        if (equal(tok->next, KW_IF) || equal(tok->next, sym_ifdef) ||
+            equal(tok->next, sym_ifndef))
+            tok = skip_cond_incl2(tok->next->next);
+        else
+            tok = tok->next;
+    }
+    return SYM_NONE;
+}
+
+static Token *include_file(Token *tok, char *path, Token *filename_tok)
+{
+    // check for "#pragma once"
+    if (pragma_once.count(path))
+        return tok;
+
+    // if we read the same file before, and if the file was guarded
+    // by the usual #ifndef ... #endif pattern, we may be able to
+    // skip the file without opening it
+    auto guard = include_guards.find(path);
+    if (guard != include_guards.end() && is_defined(guard->second))
+        return tok;
+
+    if (!file_exists(path))
+        error_tok(filename_tok, "%s: cannot open file", path);
+
+    // headers come from the token cache when possible
+    SourceFile *file = read_source_file(path);
+    int guard_sym;
+    Token *tok2 = load_cached_tokens(file, &guard_sym);
+    if (!tok2) {
+        tok2 = tokenize(file);
+        guard_sym = detect_include_guard(tok2);
+        store_cached_tokens(file, tok2, guard_sym);
+    }
+
+    if (guard_sym)
+        include_guards[path] = guard_sym;
+
+    return append(tok2, tok);
+}
+
+
+// visits all tokens in `tok` while evaluating preprocessing
+// macros and directives
+static Token *preprocess2(Token *tok)
+{
+    Token head = {};
+    Token *cur = &head;
+
+    while (tok->kind != TK_EOF) {
+        // if it is a macro, expand it
+        if (expand_macro(&tok, tok))
+            continue;
+
+        // pass through if it is not a "#"
+        if (!is_hash(tok)) {
+            cur = cur->next = tok;
+            tok = tok->next;
+            continue;
+        }
+
+        Token *start = tok;
+        tok = tok->next;
+
+        if (equal(tok, sym_include)) {
+            bool is_dquote;
+            char *filename = read_include_filename(&tok, tok->next, &is_dquote);
+
+            // a relative "..." path is looked up next to the current file first
+            if (filename[0] != '/' && is_dquote) {
+                char *dir = dirname(strdup(find_source_file(start->loc)->name));
+                char *path = format("%s/%s", dir, filename);
+                if (file_exists(path)) {
+                    tok = include_file(tok, path, start->next->next);
+                    continue;
+                }
+            }
+
+            char *path = search_include_paths(filename);
+            tok = include_file(tok, path ? path : filename, start->next->next);
+            continue;
+        }
+
+        if (equal(tok, sym_define)) {
+            read_macro_definition(&tok, tok->next);
+            continue;
+        }
+
+        if (equal(tok, sym_undef)) {
+            tok = tok->next;
+            if (!is_macro_name(tok))
+                error_tok(tok, "macro name must be an identifier");
+            undef_macro(tok->sym);
+            tok = skip_line(tok->next);
+            continue;
+        }
+
+        if (equal(tok, KW_IF)) {
+            bool val = eval_const_expr(&tok, tok);
+            push_cond_incl(start, val);
+            if (!val)
+                tok = skip_cond_incl(tok);
+            continue;
+        }
+
+        if (equal(tok, sym_ifdef) || equal(tok, sym_ifndef)) {
+            bool is_ifdef = equal(tok, sym_ifdef);
+            bool defined = find_macro(tok->next);
+            push_cond_incl(tok, defined == is_ifdef);
+            tok = skip_line(tok->next->next);
+            if (defined != is_ifdef)
+                tok = skip_cond_incl(tok);
+            continue;
+        }
+
+        if (equal(tok, sym_elif)) {
+            if (!cond_incl || cond_incl->ctx == CondIncl::IN_ELSE)
+                error_tok(start, "stray #elif");
+            cond_incl->ctx = CondIncl::IN_ELIF;
+
+            if (!cond_incl->included && eval_const_expr(&tok, tok))
+                cond_incl->included = true;
+            else
+                tok = skip_cond_incl(tok);
+            continue;
+        }
+
+        if (equal(tok, KW_ELSE)) {
+            if (!cond_incl || cond_incl->ctx == CondIncl::IN_ELSE)
+                error_tok(start, "stray #else");
+            cond_incl->ctx = CondIncl::IN_ELSE;
+            tok = skip_line(tok->next);
+
+            if (cond_incl->included)
+                tok = skip_cond_incl(tok);
+            continue;
+        }
+
+        if (equal(tok, sym_endif)) {
+            if (!cond_incl)
+                error_tok(start, "stray #endif");
+            cond_incl = cond_incl->next;
+            tok = skip_line(tok->next);
+            continue;
+        }
+
+        if (equal(tok, sym_pragma) && equal(tok->next, sym_once)) {
+            pragma_once.insert(find_source_file(tok->loc)->name);
+            tok = skip_line(tok->next->next);
+            continue;
+        }
+
+        if (equal(tok, sym_pragma)) {
+            // other pragmas are ignored
+            tok = skip_line(tok->next);
+            continue;
+        }
+
+        if (equal(tok, sym_error))
+            error_tok(tok, "error");
+
+        // `#`-only line is legal. it's called a null directive.
+        if (tok->at_bol)
+            continue;
+
+        error_tok(tok, "invalid preprocessor directive");
+    }
+
+    cur->next = tok;
+    return head.next;
+}
+
+
+void add_include_path(char *dir)
+{
+    include_paths = (char**)realloc(include_paths,
+                                    sizeof(char*) * (num_include_paths + 1));
+    include_paths[num_include_paths++] = dir;
+}
+
+
+static int intern_str(char *name)
+{
+    return intern(name, strlen(name));
+}
+
+
+// entry point function of the preprocessor
+Token *preprocess(Token *tok)
+{
+    sym_include = intern_str("include");
+    sym_define = intern_str("define");
+    sym_undef = intern_str("undef");
+    sym_ifdef = intern_str("ifdef");
+    sym_ifndef = intern_str("ifndef");
+    sym_elif = intern_str("elif");
+    sym_endif = intern_str("endif");
+    sym_pragma = intern_str("pragma");
+    sym_error = intern_str("error");
+    sym_once = intern_str("once");
+    sym_defined = intern_str("defined");
+
+    tok = preprocess2(tok);
+    if (cond_incl)
+        error_tok(cond_incl->tok, "unterminated conditional directive");
+    return tok;
+}
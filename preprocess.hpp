@@ -0,0 +1,11 @@
+#ifndef PCC_PREPROCESS_H
+#define PCC_PREPROCESS_H
+
+
+struct Token;
+
+void add_include_path(char *dir);
+Token *preprocess(Token *tok);
+
+
+#endif /* PCC_PREPROCESS_H */
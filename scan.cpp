@@ -0,0 +1,331 @@
+#include <stdint.h>
+#include "scan.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PCC_HAVE_SSE2 1
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define PCC_HAVE_AVX2 1
+#endif
+
+
+//
+// Scalar reference implementation
+//
+// These are the definitions the vector versions must agree with, and
+// are what `--scan=scalar` runs for differential testing.
+//
+
+// whitespace other than '\n'
+static bool is_space(char c)
+{
+    return c == ' ' || ('\t' <= c && c <= '\r' && c != '\n');
+}
+
+static bool is_ident(char c)
+{
+    return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+           ('0' <= c && c <= '9') || c == '_';
+}
+
+static char *scalar_skip_space(char *p)
+{
+    while (is_space(*p))
+        ++p;
+    return p;
+}
+
+static char *scalar_skip_ident(char *p)
+{
+    while (is_ident(*p))
+        ++p;
+    return p;
+}
+
+static char *scalar_skip_digits(char *p)
+{
+    while ('0' <= *p && *p <= '9')
+        ++p;
+    return p;
+}
+
+static char *scalar_find_newline(char *p)
+{
+    while (*p != '\n' && *p != '\0')
+        ++p;
+    return p;
+}
+
+static char *scalar_find_quote(char *p)
+{
+    while (*p != '"' && *p != '\\' && *p != '\n' && *p != '\0')
+        ++p;
+    return p;
+}
+
+static char *scalar_find_comment_end(char *p)
+{
+    for (; *p; ++p)
+        if (p[0] == '*' && p[1] == '/')
+            return p;
+    return nullptr;
+}
+
+
+// The vector scanners below all share one shape: align `p` down to the
+// vector width, compute a bitmask of bytes that stop the scan, discard
+// the bits for bytes before `p`, and walk forward one aligned block at
+// a time until some bit is set. Aligned loads never straddle a page
+// boundary, so reading a whole block around the terminating '\0' is safe.
+// AddressSanitizer can't tell, so the scanners aren't instrumented.
+// LEAVE runs before returning.
+#define NO_ASAN __attribute__((no_sanitize_address))
+
+#define SCAN_BLOCKS(VEC, WIDTH, LOAD, STOP, LEAVE)                     \
+    do {                                                               \
+        uintptr_t off = (uintptr_t)p & (WIDTH - 1);                    \
+        const VEC *q = (const VEC *)(p - off);                         \
+        uint32_t m = (uint32_t)(STOP(LOAD(q))) >> off;                 \
+        if (m) {                                                       \
+            LEAVE;                                                     \
+            return p + __builtin_ctz(m);                               \
+        }                                                              \
+        for (;;) {                                                     \
+            m = STOP(LOAD(++q));                                       \
+            if (m) {                                                   \
+                LEAVE;                                                 \
+                return (char *)q + __builtin_ctz(m);                   \
+            }                                                          \
+        }                                                              \
+    } while (0)
+
+
+//
+// SSE2
+//
+
+#ifdef PCC_HAVE_SSE2
+
+// bytes of x within [lo, hi], as 0xff lanes
+static inline __m128i sse2_in_range(__m128i x, char lo, char hi)
+{
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+    __m128i over = _mm_subs_epu8(d, _mm_set1_epi8(hi - lo));
+    return _mm_cmpeq_epi8(over, _mm_setzero_si128());
+}
+
+static inline __m128i sse2_eq(__m128i x, char c)
+{
+    return _mm_cmpeq_epi8(x, _mm_set1_epi8(c));
+}
+
+static inline uint32_t sse2_not_space(__m128i x)
+{
+    __m128i m = _mm_andnot_si128(sse2_eq(x, '\n'), sse2_in_range(x, '\t', '\r'));
+    m = _mm_or_si128(m, sse2_eq(x, ' '));
+    return ~_mm_movemask_epi8(m) & 0xffff;
+}
+
+static inline uint32_t sse2_not_ident(__m128i x)
+{
+    __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+    __m128i m = _mm_or_si128(sse2_in_range(lower, 'a', 'z'),
+                             sse2_in_range(x, '0', '9'));
+    m = _mm_or_si128(m, sse2_eq(x, '_'));
+    return ~_mm_movemask_epi8(m) & 0xffff;
+}
+
+static inline uint32_t sse2_not_digit(__m128i x)
+{
+    return ~_mm_movemask_epi8(sse2_in_range(x, '0', '9')) & 0xffff;
+}
+
+static inline uint32_t sse2_newline(__m128i x)
+{
+    return _mm_movemask_epi8(_mm_or_si128(sse2_eq(x, '\n'), sse2_eq(x, '\0')));
+}
+
+static inline uint32_t sse2_quote(__m128i x)
+{
+    __m128i m = _mm_or_si128(sse2_eq(x, '"'), sse2_eq(x, '\\'));
+    m = _mm_or_si128(m, _mm_or_si128(sse2_eq(x, '\n'), sse2_eq(x, '\0')));
+    return _mm_movemask_epi8(m);
+}
+
+static inline uint32_t sse2_star(__m128i x)
+{
+    return _mm_movemask_epi8(_mm_or_si128(sse2_eq(x, '*'), sse2_eq(x, '\0')));
+}
+
+#define SSE2_SCAN(STOP) SCAN_BLOCKS(__m128i, 16, _mm_load_si128, STOP, (void)0)
+
+NO_ASAN static char *sse2_skip_space(char *p) { SSE2_SCAN(sse2_not_space); }
+NO_ASAN static char *sse2_skip_ident(char *p) { SSE2_SCAN(sse2_not_ident); }
+NO_ASAN static char *sse2_skip_digits(char *p) { SSE2_SCAN(sse2_not_digit); }
+NO_ASAN static char *sse2_find_newline(char *p) { SSE2_SCAN(sse2_newline); }
+NO_ASAN static char *sse2_find_quote(char *p) { SSE2_SCAN(sse2_quote); }
+
+NO_ASAN static char *sse2_find_star(char *p) { SSE2_SCAN(sse2_star); }
+
+static char *sse2_find_comment_end(char *p)
+{
+    for (;;) {
+        p = sse2_find_star(p);
+        if (*p == '\0')
+            return nullptr;
+        if (p[1] == '/')
+            return p;
+        ++p;
+    }
+}
+
+#endif
+
+
+//
+// AVX2, compiled regardless of -march and only selected at runtime
+//
+
+#ifdef PCC_HAVE_AVX2
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i avx2_in_range(__m256i x, char lo, char hi)
+{
+    __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+    __m256i over = _mm256_subs_epu8(d, _mm256_set1_epi8(hi - lo));
+    return _mm256_cmpeq_epi8(over, _mm256_setzero_si256());
+}
+
+AVX2 static inline __m256i avx2_eq(__m256i x, char c)
+{
+    return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c));
+}
+
+AVX2 static inline uint32_t avx2_not_space(__m256i x)
+{
+    __m256i m = _mm256_andnot_si256(avx2_eq(x, '\n'), avx2_in_range(x, '\t', '\r'));
+    m = _mm256_or_si256(m, avx2_eq(x, ' '));
+    return ~(uint32_t)_mm256_movemask_epi8(m);
+}
+
+AVX2 static inline uint32_t avx2_not_ident(__m256i x)
+{
+    __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+    __m256i m = _mm256_or_si256(avx2_in_range(lower, 'a', 'z'),
+                                avx2_in_range(x, '0', '9'));
+    m = _mm256_or_si256(m, avx2_eq(x, '_'));
+    return ~(uint32_t)_mm256_movemask_epi8(m);
+}
+
+AVX2 static inline uint32_t avx2_not_digit(__m256i x)
+{
+    return ~(uint32_t)_mm256_movemask_epi8(avx2_in_range(x, '0', '9'));
+}
+
+AVX2 static inline uint32_t avx2_newline(__m256i x)
+{
+    return _mm256_movemask_epi8(
+        _mm256_or_si256(avx2_eq(x, '\n'), avx2_eq(x, '\0')));
+}
+
+AVX2 static inline uint32_t avx2_quote(__m256i x)
+{
+    __m256i m = _mm256_or_si256(avx2_eq(x, '"'), avx2_eq(x, '\\'));
+    m = _mm256_or_si256(m, _mm256_or_si256(avx2_eq(x, '\n'), avx2_eq(x, '\0')));
+    return _mm256_movemask_epi8(m);
+}
+
+AVX2 static inline uint32_t avx2_star(__m256i x)
+{
+    return _mm256_movemask_epi8(
+        _mm256_or_si256(avx2_eq(x, '*'), avx2_eq(x, '\0')));
+}
+
+// the rest of the program is built for SSE only, and leaving the upper
+// halves of the ymm registers dirty makes every later SSE instruction
+// pay for a state transition, so clear them on the way out
+#define AVX2_SCAN(STOP) \
+    SCAN_BLOCKS(__m256i, 32, _mm256_load_si256, STOP, _mm256_zeroupper())
+
+AVX2 NO_ASAN static char *avx2_skip_space(char *p) { AVX2_SCAN(avx2_not_space); }
+AVX2 NO_ASAN static char *avx2_skip_ident(char *p) { AVX2_SCAN(avx2_not_ident); }
+AVX2 NO_ASAN static char *avx2_skip_digits(char *p) { AVX2_SCAN(avx2_not_digit); }
+AVX2 NO_ASAN static char *avx2_find_newline(char *p) { AVX2_SCAN(avx2_newline); }
+AVX2 NO_ASAN static char *avx2_find_quote(char *p) { AVX2_SCAN(avx2_quote); }
+
+AVX2 NO_ASAN static char *avx2_find_star(char *p) { AVX2_SCAN(avx2_star); }
+
+AVX2 static char *avx2_find_comment_end(char *p)
+{
+    for (;;) {
+        p = avx2_find_star(p);
+        if (*p == '\0')
+            return nullptr;
+        if (p[1] == '/')
+            return p;
+        ++p;
+    }
+}
+
+#endif
+
+
+static bool select_scanner(ScanMode mode, Scanner *s)
+{
+    switch (mode) {
+    case SCAN_AUTO:
+        if (select_scanner(SCAN_AVX2, s))
+            return true;
+        if (select_scanner(SCAN_SSE2, s))
+            return true;
+        return select_scanner(SCAN_SCALAR, s);
+
+    case SCAN_SCALAR:
+        *s = {scalar_skip_space, scalar_skip_ident, scalar_skip_digits,
+              scalar_find_newline, scalar_find_quote, scalar_find_comment_end};
+        return true;
+
+    case SCAN_SSE2:
+#ifdef PCC_HAVE_SSE2
+        *s = {sse2_skip_space, sse2_skip_ident, sse2_skip_digits,
+              sse2_find_newline, sse2_find_quote, sse2_find_comment_end};
+        return true;
+#else
+        return false;
+#endif
+
+    case SCAN_AVX2:
+#ifdef PCC_HAVE_AVX2
+        // may run from a static initializer, before libgcc has probed
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2"))
+            return false;
+        *s = {avx2_skip_space, avx2_skip_ident, avx2_skip_digits,
+              avx2_find_newline, avx2_find_quote, avx2_find_comment_end};
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+
+static Scanner default_scanner()
+{
+    Scanner s;
+    select_scanner(SCAN_AUTO, &s);
+    return s;
+}
+
+Scanner scanner = default_scanner();
+
+
+bool set_scan_mode(ScanMode mode)
+{
+    return select_scanner(mode, &scanner);
+}
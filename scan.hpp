@@ -0,0 +1,50 @@
+#ifndef PCC_SCAN_H
+#define PCC_SCAN_H
+
+
+// Byte scanners used by the tokenizer to skip over runs of characters.
+//
+// Every scanner starts at `p` and returns a pointer to the first byte
+// that stops the scan. The input must be terminated by '\0', which
+// always stops a scan. Vector implementations only issue aligned loads,
+// so they never touch a page that doesn't contain part of the input.
+struct Scanner
+{
+    // first byte that is not whitespace, or is '\n'. the tokenizer
+    // handles newlines itself to keep track of where lines start.
+    char *(*skip_space)(char *p);
+
+    // first byte that is not [A-Za-z0-9_]
+    char *(*skip_ident)(char *p);
+
+    // first byte that is not [0-9]
+    char *(*skip_digits)(char *p);
+
+    // first '\n' or '\0'
+    char *(*find_newline)(char *p);
+
+    // first '"', '\\', '\n' or '\0'
+    char *(*find_quote)(char *p);
+
+    // first "*/", or NULL if the input ends before one
+    char *(*find_comment_end)(char *p);
+};
+
+
+enum ScanMode
+{
+    SCAN_AUTO,   // the widest vector unit the CPU supports
+    SCAN_SCALAR, // byte-at-a-time reference implementation
+    SCAN_SSE2,
+    SCAN_AVX2
+};
+
+
+extern Scanner scanner;
+
+// Selects the scanner implementation. Returns false if the requested
+// mode isn't supported by this CPU or build.
+bool set_scan_mode(ScanMode mode);
+
+
+#endif /* PCC_SCAN_H */
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include "source.hpp"
+
+
+// all registered files, sorted by the address of their buffers
+static SourceFile **files;
+static int num_files;
+
+// files read from disk or stdin, in order of file_no
+static SourceFile **input_files;
+static int num_input_files;
+
+
+SourceFile *new_input_file(char *name, char *contents, int size)
+{
+    SourceFile *file = new_source_file(name, num_input_files + 1, contents, size);
+    input_files = (SourceFile**)realloc(input_files,
+                                       sizeof(SourceFile*) * (num_input_files + 1));
+    input_files[num_input_files++] = file;
+    return file;
+}
+
+
+SourceFile **get_input_files(int *num)
+{
+    *num = num_input_files;
+    return input_files;
+}
+
+
+SourceFile *new_source_file(char *name, int file_no, char *contents, int size)
+{
+    SourceFile *file = (SourceFile*)calloc(1, sizeof(SourceFile));
+    file->name = name;
+    file->file_no = file_no;
+    file->contents = contents;
+    file->end = contents + size;
+    add_line(file, contents);
+
+    files = (SourceFile**)realloc(files, sizeof(SourceFile*) * (num_files + 1));
+    int i = num_files++;
+    for (; i > 0 && files[i - 1]->contents > contents; --i)
+        files[i] = files[i - 1];
+    files[i] = file;
+    return file;
+}
+
+
+void grow_lines(SourceFile *file)
+{
+    file->line_capacity = file->line_capacity ? file->line_capacity * 2 : 1024;
+    file->line_starts = (int*)realloc(file->line_starts,
+                                      sizeof(int) * file->line_capacity);
+}
+
+
+SourceFile *find_source_file(char *loc)
+{
+    // the last file whose buffer starts at or before loc
+    int lo = 0, hi = num_files;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (files[mid]->contents <= loc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0 || loc > files[lo - 1]->end)
+        return nullptr;
+    return files[lo - 1];
+}
+
+
+// index of the last line starting at or before loc
+static int find_line(SourceFile *file, char *loc)
+{
+    int off = loc - file->contents;
+    int lo = 0, hi = file->num_lines;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (file->line_starts[mid] <= off)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - 1;
+}
+
+
+int get_line_no(SourceFile *file, char *loc)
+{
+    return find_line(file, loc) + 1;
+}
+
+
+char *get_line_start(SourceFile *file, char *loc)
+{
+    return file->contents + file->line_starts[find_line(file, loc)];
+}
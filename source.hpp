@@ -0,0 +1,52 @@
+#ifndef PCC_SOURCE_H
+#define PCC_SOURCE_H
+
+
+// A source buffer together with the offsets at which its lines start.
+// The tokenizer records line starts as it crosses newlines, so mapping
+// a location back to a line is a binary search rather than a rescan.
+struct SourceFile
+{
+    char *name;
+    int file_no;    // 1-based, for .file/.loc directives
+    char *contents; // terminated by '\0'
+    char *end;      // the terminating '\0'
+
+    // line_starts[i] is the offset of line i + 1; always sorted
+    int *line_starts;
+    int num_lines;
+    int line_capacity;
+};
+
+
+// registers `contents`, which has `size` bytes followed by a '\0'.
+// input files are numbered in the order they're read; other buffers
+// (e.g. text made by the preprocessor) borrow the name and number of
+// the file they came from.
+SourceFile *new_input_file(char *name, char *contents, int size);
+SourceFile *new_source_file(char *name, int file_no, char *contents, int size);
+
+// returns the input files in order of file_no
+SourceFile **get_input_files(int *num);
+void grow_lines(SourceFile *file);
+
+// records that a new line begins at `p`, which must be past every line
+// start recorded so far for `file`
+inline void add_line(SourceFile *file, char *p)
+{
+    if (file->num_lines == file->line_capacity)
+        grow_lines(file);
+    file->line_starts[file->num_lines++] = p - file->contents;
+}
+
+// returns the file whose buffer contains `loc`, or NULL
+SourceFile *find_source_file(char *loc);
+
+// returns the 1-based line number of `loc` within `file`
+int get_line_no(SourceFile *file, char *loc);
+
+// returns the start of the line containing `loc`
+char *get_line_start(SourceFile *file, char *loc);
+
+
+#endif /* PCC_SOURCE_H */
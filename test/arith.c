@@ -63,6 +63,13 @@ int main() {
   ASSERT(2, ({ int a[3]; a[0]=0; a[1]=1; a[2]=2; int *p=a+1; (*p++)--; a[2]; }));
   ASSERT(2, ({ int a[3]; a[0]=0; a[1]=1; a[2]=2; int *p=a+1; (*p++)--; *p; }));
 
+  ASSERT(14, ({ int a[3]; a[0]=0; a[1]=10; a[2]=20; int i=1; a[i++]+=2; a[1]+i; }));
+  ASSERT(9, ({ int x=2; int y=3; x+=(y+=4); x; }));
+  ASSERT(7, ({ int x=2; int y=3; x+=(y+=4); y; }));
+  ASSERT(44, ({ char c=100; c+=200; c; }));
+  ASSERT(20, ({ int a[3]; a[0]=0; a[1]=10; a[2]=20; int *p=a; p+=2; *p; }));
+  ASSERT(5, ({ int x=1; int i=0; for (; i<4; i+=1) x++; x; }));
+
   ASSERT(0, !1);
   ASSERT(0, !2);
   ASSERT(1, !0);
@@ -76,6 +83,9 @@ int main() {
 
   ASSERT(5, 17%6);
   ASSERT(5, ((long)17)%6);
+  ASSERT(10, 17%6*2);
+  ASSERT(1, 17%6%2);
+  ASSERT(9, 3+17%6*2-4);
   ASSERT(2, ({ int i=10; i%=4; i; }));
   ASSERT(2, ({ long i=10; i%=4; i; }));
 
@@ -91,6 +101,21 @@ int main() {
   ASSERT(0, 0b1111^0b1111);
   ASSERT(0b110100, 0b111000^0b001100);
 
+  ASSERT(-2147483648, 2147483647 + 1);
+  ASSERT(0, 2147483647 + 1 > 0);
+  ASSERT(1073741824, ((long)2147483647 + 1) / 2);
+  ASSERT(-1, -7 / 2 + 2);
+  ASSERT(-1, -7 % 2);
+  ASSERT(1, 7 % -2);
+  ASSERT(0, 0 && 1 / 0);
+  ASSERT(1, 1 || 1 / 0);
+  ASSERT(12, ({ int x=5; 2 + x + 5; }));
+  ASSERT(6, ({ int x=5; x + 10 - 3 - 6; }));
+  ASSERT(35, ({ int x=5; 7 * x * 1; }));
+  ASSERT(7, ({ int x=5; 2 | x | 0; }));
+  ASSERT(1, ({ long x=5; x * 3 * 2 == 30; }));
+  ASSERT(8, ({ long x=5; sizeof(x + 0); }));
+
   ASSERT(2, ({ int i=6; i&=3; i; }));
   ASSERT(7, ({ int i=6; i|=3; i; }));
   ASSERT(10, ({ int i=15; i^=5; i; }));
@@ -5,6 +5,10 @@ int main() {
   ASSERT(513, (short)8590066177);
   ASSERT(1, (char)8590066177);
   ASSERT(1, (long)1);
+  ASSERT(44, (char)300);
+  ASSERT(-1, (short)65535);
+  ASSERT(4, sizeof((char)1 + (char)2));
+  ASSERT(8, sizeof((long)1 + 2));
   ASSERT(0, (long)&*(int *)0);
   ASSERT(513, ({ int x=512; *(char *)&x=1; x; }));
   ASSERT(5, ({ int x=5; long y=(long)&x; *(int*)y; }));
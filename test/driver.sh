@@ -22,4 +22,96 @@ check -o
 ../build/pcc --help 2>&1 | grep -q pcc
 check --help
 
+# a program both the IR and the codegen build compile: comments,
+# numbers, macros from a header and several function bodies. It has
+# no global variables, whose IR prints the address of their type.
+cat > $tmp/sample.h <<'EOF'
+#define SQ(x) ((x) * (x))
+#define ADD(a, b) ((a) + (b))
+#define K 0x1F
+EOF
+cat > $tmp/sample.c <<'EOF'
+#include "sample.h"
+/* a comment
+   over two lines */
+static int twice(int a) { return ADD(a, a); } // line comment
+int f(int a, int b) {
+  int s = 0;
+  for (int i = 0; i < a; i = i + 1) {
+    if (i % 3 == 1) s = s + SQ(i) * b;
+    else s = s - i * 4 + K;
+  }
+  while (s > 1000) s = s / 2;
+  return twice(s) + sizeof(int) + 017;
+}
+int main() { return f(3, 4) != 31; }
+EOF
+
+# a file big enough to be tokenized in chunks, with comments
+# spanning lines everywhere
+awk 'BEGIN {
+    for (i = 0; i < 60000; i++) {
+        printf "/* block %d\n   spans two lines */ // and a line comment\n", i
+        if (i % 2000 == 0)
+            printf "int f%d(int a) { return a + %d; }\n", i, i
+    }
+    print "int main() { return f0(0); }"
+}' > $tmp/big.c
+
+# compile $1 with the options $2, then with $3: both must succeed
+# and print the same
+same_output() {
+    ../build/pcc $2 $1 > $tmp/first.out 2>&1 &&
+        ../build/pcc $3 $1 > $tmp/second.out 2>&1 &&
+        cmp -s $tmp/first.out $tmp/second.out
+}
+
+# --scan: every vector scanner must tokenize exactly like the scalar one
+for mode in sse2 avx2; do
+    # skip modes this machine doesn't support
+    ../build/pcc --scan=$mode $tmp/empty.c > /dev/null 2>&1 || continue
+    for f in $tmp/sample.c $tmp/big.c; do
+        same_output $f --scan=scalar --scan=$mode
+        check "--scan=$mode ${f##*/}"
+    done
+done
+
+# --token-cache: a cold and a warm cache must both match no cache at all
+same_output $tmp/sample.c "" --token-cache=$tmp/cache &&
+    ls $tmp/cache/*.ptc > /dev/null 2>&1 &&
+    same_output $tmp/sample.c "" --token-cache=$tmp/cache
+check --token-cache
+
+# -j: chunked tokenizing and parallel body parsing must compile
+# exactly as with one thread
+for f in $tmp/sample.c $tmp/big.c; do
+    same_output $f -j1 -j4
+    check "-j ${f##*/}"
+done
+
+# -j: each body sees only the file scope before it, and the first
+# error in reading order is reported
+printf 'int f() { return g; }\nint g;\nint h() { return 1 + ; }\n' > $tmp/late.c
+../build/pcc -j4 $tmp/late.c 2>&1 | grep -q 'undefined variable'
+check "-j declaration order"
+
+# --lazy-static: static functions nothing reachable refers to are
+# skipped; the names of the others appear in the IR and the assembly
+same_output $tmp/sample.c "" --lazy-static
+check --lazy-static
+printf 'static int lazy_used() { return 1; }\nstatic int lazy_dead() { return 1 + ; }\nstatic int g() { return lazy_used(); }\nint main() { return g(); }\n' > $tmp/lazy.c
+../build/pcc --lazy-static $tmp/lazy.c > $tmp/lazy.out 2>&1 &&
+    grep -q lazy_used $tmp/lazy.out && ! grep -q lazy_dead $tmp/lazy.out
+check "--lazy-static reachability"
+
+# IR fixtures: when the build prints IR, each ir/*.c must print its
+# ir/*.ir after the passes, with the passes on one thread or several
+if ../build/pcc ir/loop.c 2>/dev/null | grep -q '^define'; then
+    for f in ir/*.c; do
+        ../build/pcc $f 2>&1 | cmp -s - ${f%.c}.ir &&
+            same_output $f -j1 -j8
+        check "${f##*/}"
+    done
+fi
+
 echo OK
@@ -0,0 +1,8 @@
+#ifndef INCLUDE1_H
+#define INCLUDE1_H
+
+#include "include2.h"
+
+int include1() { return 5; }
+
+#endif
@@ -0,0 +1,3 @@
+#pragma once
+
+int include2() { return 7; }
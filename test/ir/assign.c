@@ -0,0 +1,7 @@
+int f(int x)
+{
+    int c = 0;
+    c += x;
+    c++;
+    return c;
+}
@@ -0,0 +1,15 @@
+int f(int x, int y)
+{
+    int a = x + y;
+    int b = x + y;
+    int c = 0;
+    if (a > 3) {
+        c = a * 2;
+    } else {
+        c = b - 1;
+    }
+    while (c < 100) {
+        c = c + 3;
+    }
+    return c + (3 + 4) * 2 % 5 + ~y - x;
+}
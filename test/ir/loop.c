@@ -0,0 +1,8 @@
+int f(int init)
+{
+    int sum = init;
+    for (int i = 0; i < 10; i = i + 1) {
+        sum = sum + i;
+    }
+    return sum;
+}
@@ -0,0 +1,36 @@
+// branches whose arms both go to the same block, with different
+// arguments for its parameters
+int f(int a, int b)
+{
+    int s = b;
+    if (a)
+        s = 3;
+    return s;
+}
+
+int g(int a, int b)
+{
+    int s = b;
+    int t = 0;
+    if (a) {
+        s = 3;
+        t = 1;
+    }
+    if (t)
+        return s;
+    return s + 1;
+}
+
+int h(int a, int b)
+{
+    int s = b;
+    int u = 0;
+    for (int i = 0; i < a; i = i + 1) {
+        if (i)
+            s = 3;
+        u = u + 1;
+    }
+    return s;
+}
+
+int main() { return 0; }
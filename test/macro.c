@@ -0,0 +1,177 @@
+#include "test.h"
+#include "include1.h"
+#include "include1.h"
+#include "include2.h"
+
+int strcmp(char *p, char *q);
+int ret3() { return 3; }
+int dbl(int x) { return x*x; }
+
+int main() {
+  ASSERT(5, include1());
+  ASSERT(7, include2());
+
+  int m;
+
+#if 0
+#include "/no/such/file"
+  m = 1;
+  #foo bar
+#endif
+  m = 2;
+  ASSERT(2, m);
+
+#if 1
+  m = 3;
+#endif
+  ASSERT(3, m);
+
+  #
+
+#if 1-1
+# if 1
+# endif
+# if 1
+# else
+# endif
+# if 0
+#  if 1
+#  else
+#  endif
+# endif
+  m = 4;
+#endif
+
+#if 0
+#elif 1 == 1
+  m = 5;
+#else
+  m = 6;
+#endif
+  ASSERT(5, m);
+
+#if 0
+  m = 7;
+#elif 0
+  m = 8;
+#else
+  m = 9;
+#endif
+  ASSERT(9, m);
+
+#if 1 && (2 + 3 * 4 == 14) && !0 && 1 ? 1 : 0
+  m = 10;
+#else
+  m = 11;
+#endif
+  ASSERT(10, m);
+
+#define M1 3
+  ASSERT(3, M1);
+#define M1 4
+  ASSERT(4, M1);
+
+#define M1 3+4+
+  ASSERT(12, M1 5);
+
+#define M1 3+4
+  ASSERT(23, M1*5);
+
+#define ASSERT_ assert(
+#define if 5
+#define ret_ return
+#define int_ int
+  ASSERT_ 1, 1, "1");
+#undef if
+
+#undef M1
+  int M1 = 6;
+  ASSERT(6, M1);
+
+#define M2 M1 + 1
+  ASSERT(7, M2);
+
+#ifdef M1
+  m = 12;
+#else
+  m = 13;
+#endif
+  ASSERT(13, m);
+
+#define M1
+#ifdef M1
+  m = 14;
+#endif
+  ASSERT(14, m);
+
+#ifndef M1
+  m = 15;
+#else
+  m = 16;
+#endif
+  ASSERT(16, m);
+
+#if defined(M1) && defined M2 && !defined(M3)
+  m = 17;
+#endif
+  ASSERT(17, m);
+
+#if NO_SUCH_MACRO
+  m = 18;
+#else
+  m = 19;
+#endif
+  ASSERT(19, m);
+
+  // operands skipped by &&, || and ?: are never evaluated
+#if 0 && 1/0
+  m = 20;
+#elif 1 || 1%0
+  m = 21;
+#endif
+  ASSERT(21, m);
+
+#if defined(NO_SUCH_MACRO) && 10/NO_SUCH_MACRO
+  m = 22;
+#elif NO_SUCH_MACRO ? 1/NO_SUCH_MACRO : 2 + 1
+  m = 23;
+#endif
+  ASSERT(23, m);
+
+#define M4(x) x*x
+  ASSERT(9, M4(3));
+  ASSERT(31, M4(2+3) + 20);
+
+#define M5(x, y) x-y
+  ASSERT(-1, M5(2, 3));
+  ASSERT(3, M5((1, 5), (2)));
+
+#define M6() 5
+  ASSERT(5, M6());
+
+#define dbl(x) M7(dbl(x))
+#define M7(x) M8(x)
+#define M8(x) (x + 1)
+  ASSERT(10, dbl(3));
+
+  int M9 = 4;
+#define M9 M9 + 1
+  ASSERT(5, M9);
+
+  int g = 2;
+#define f(a) a*g
+#define g(a) f(a)
+  ASSERT(36, f(2)(9));
+
+#define STR(x) #x
+  ASSERT(0, strcmp(STR(a  b    "c\n"), "a b \"c\\n\""));
+
+#define CAT(x, y) x##y
+  ASSERT(42, CAT(4, 2));
+  ASSERT(3, CAT(re, t3)());
+  int CAT(x, y) = 11;
+  ASSERT(11, xy);
+
+  printf("OK\n");
+  return 0;
+}
@@ -16,7 +16,7 @@ def clear():
 
 
 for test_file, assembly_file, exe_file in zip(test_files, assembly_files, exe_files):
-    subprocess.run(f"gcc -o- -E -P -C {test_file} | {pcc} -o {assembly_file} -", shell=True)
+    subprocess.run(f"{pcc} -o {assembly_file} {test_file}", shell=True)
     subprocess.run(f"gcc -o {exe_file} {assembly_file} -xc common", shell=True)
 
 
@@ -52,6 +52,11 @@ int main() {
   ASSERT(16, ({ struct {char a; long b;} x; sizeof(x); }));
   ASSERT(4, ({ struct {char a; short b;} x; sizeof(x); }));
 
+  ASSERT(12, ({ struct {int a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q;} x; x.a=1; x.h=3; x.q=8; x.a+x.h+x.q; }));
+  ASSERT(64, ({ struct {int a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q;} x; (long)&x.q-(long)&x; }));
+  ASSERT(6, ({ union {int a,b,c,d,e,f,g,h,i,j;} x; x.j=6; x.a; }));
+  ASSERT(1, ({ struct {} x; sizeof(x) == 0; }));
+
   printf("OK\n");
   return 0;
 }
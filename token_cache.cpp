@@ -0,0 +1,331 @@
+// This file implements a persistent cache of tokenized headers.
+//
+// A cache entry is named after a hash of the header's contents, so the
+// same text is tokenized once no matter which path or translation unit
+// it's included from. An entry is a single binary file that is mapped
+// into memory and turned into a token list without lexing anything:
+//
+//   CacheHeader
+//   CachedToken[num_tokens]   fixed-size token records
+//   int32_t[num_lines]        line start offsets
+//   symbol table              (uint32_t len, char[len]) per identifier
+//   string blob               decoded string literals, '\0'-terminated
+//
+// Locations are stored as offsets into the header's text, which is read
+// anyway to compute the hash. Identifiers are stored as indexes into the
+// entry's own symbol table and interned once each on load. The include
+// guard found by the preprocessor is recorded too, so a cached header
+// is never rescanned for it.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <unordered_map>
+#include "token_cache.hpp"
+#include "tokenize.hpp"
+#include "source.hpp"
+#include "utils/util.hpp"
+
+
+// bump whenever the layout below or the meaning of a token changes
+static constexpr uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sym_ident; // SYM_IDENT of the writer; fixed ids must agree
+    uint64_t hash;
+    uint64_t source_size;
+    uint32_t num_tokens;
+    uint32_t num_lines;
+    uint32_t num_syms;
+    uint32_t guard; // 1 + symbol table index of the guard macro, or 0
+    uint64_t syms_offset;
+    uint64_t strs_offset;
+    uint64_t file_size;
+};
+
+struct CachedToken
+{
+    uint32_t loc;  // offset into the source text
+    uint32_t len;
+    uint32_t sym;  // symbol table index if TK_IDENT, str_len if TK_STR,
+                   // the symbol id otherwise
+    uint8_t kind;
+    uint8_t flags;
+    uint16_t pad;
+    int64_t val;   // the value if TK_NUM, string blob offset if TK_STR
+};
+
+enum { AT_BOL = 1, HAS_SPACE = 2 };
+
+static const char cache_magic[8] = {'P', 'C', 'C', 'T', 'O', 'K', '\0', '\n'};
+
+static char *cache_dir;
+
+
+void set_token_cache_dir(char *dir)
+{
+    if (mkdir(dir, 0777) && errno != EEXIST)
+        error("cannot create token cache directory %s: %s", dir, strerror(errno));
+    cache_dir = dir;
+}
+
+
+// 64-bit FNV-1a
+static uint64_t hash_contents(char *p, size_t len)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; ++i)
+        h = (h ^ (unsigned char)p[i]) * 1099511628211ull;
+    return h;
+}
+
+static char *cache_path(uint64_t hash)
+{
+    return format("%s/%016llx.ptc", cache_dir, (unsigned long long)hash);
+}
+
+
+// Checks what the records of an entry with a sound header refer to, so
+// a corrupt entry is a cache miss rather than a stray read.
+static bool valid_records(char *buf, CacheHeader *hdr)
+{
+    CachedToken *recs = (CachedToken*)(hdr + 1);
+    int32_t *lines = (int32_t*)(recs + hdr->num_tokens);
+    char *strs = buf + hdr->strs_offset;
+    uint64_t strs_size = hdr->file_size - hdr->strs_offset;
+
+    char *p = buf + hdr->syms_offset;
+    for (uint32_t i = 0; i < hdr->num_syms; ++i) {
+        uint32_t len;
+        if ((size_t)(strs - p) < sizeof(len))
+            return false;
+        memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        if ((size_t)(strs - p) < len)
+            return false;
+        p += len;
+    }
+    if (hdr->guard > hdr->num_syms)
+        return false;
+
+    for (uint32_t i = 0; i < hdr->num_lines; ++i)
+        if (lines[i] < 0 || (uint64_t)lines[i] > hdr->source_size)
+            return false;
+
+    for (uint32_t i = 0; i < hdr->num_tokens; ++i) {
+        CachedToken *r = &recs[i];
+        if ((uint64_t)r->loc + r->len > hdr->source_size)
+            return false;
+
+        switch (r->kind) {
+        case TK_NUM:
+            break;
+        case TK_STR:
+            // the literal and its terminator lie within the blob
+            if (r->val < 0 || (uint64_t)r->val >= strs_size ||
+                r->sym >= strs_size - r->val || strs[r->val + r->sym])
+                return false;
+            break;
+        case TK_IDENT:
+            if (r->sym >= hdr->num_syms)
+                return false;
+            break;
+        case TK_PUNCT:
+        case TK_KEYWORD:
+        case TK_EOF:
+            if (r->sym >= SYM_IDENT)
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    // the list is only ever stored whole
+    return recs[hdr->num_tokens - 1].kind == TK_EOF;
+}
+
+
+Token *load_cached_tokens(SourceFile *file, int *guard)
+{
+    if (!cache_dir)
+        return nullptr;
+
+    size_t source_size = file->end - file->contents;
+    uint64_t hash = hash_contents(file->contents, source_size);
+    char *path = cache_path(hash);
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < (off_t)sizeof(CacheHeader)) {
+        close(fd);
+        return nullptr;
+    }
+
+    // the mapping is never unmapped: string literals point into it
+    char *buf = (char*)mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (buf == MAP_FAILED)
+        return nullptr;
+
+    CacheHeader *hdr = (CacheHeader*)buf;
+    size_t records_end = sizeof(CacheHeader) +
+                         (size_t)hdr->num_tokens * sizeof(CachedToken) +
+                         (size_t)hdr->num_lines * sizeof(int32_t);
+    if (memcmp(hdr->magic, cache_magic, sizeof(cache_magic)) ||
+        hdr->version != CACHE_VERSION || hdr->sym_ident != SYM_IDENT ||
+        hdr->hash != hash || hdr->source_size != source_size ||
+        hdr->file_size != (uint64_t)st.st_size || hdr->num_tokens == 0 ||
+        hdr->num_lines == 0 || records_end > hdr->syms_offset ||
+        hdr->syms_offset > hdr->strs_offset || hdr->strs_offset > hdr->file_size ||
+        !valid_records(buf, hdr)) {
+        munmap(buf, st.st_size);
+        return nullptr;
+    }
+
+    CachedToken *recs = (CachedToken*)(hdr + 1);
+    int32_t *lines = (int32_t*)(recs + hdr->num_tokens);
+    char *strs = buf + hdr->strs_offset;
+
+    // intern the entry's identifiers
+    int *syms = (int*)malloc(sizeof(int) * (hdr->num_syms + 1));
+    char *p = buf + hdr->syms_offset;
+    for (uint32_t i = 0; i < hdr->num_syms; ++i) {
+        uint32_t len;
+        memcpy(&len, p, sizeof(len));
+        syms[i] = intern(p + sizeof(len), len);
+        p += sizeof(len) + len;
+    }
+
+    file->num_lines = 0;
+    for (uint32_t i = 0; i < hdr->num_lines; ++i)
+        add_line(file, file->contents + lines[i]);
+
+    Token *tok = new_tokens(hdr->num_tokens);
+    for (uint32_t i = 0; i < hdr->num_tokens; ++i) {
+        CachedToken *r = &recs[i];
+        Token *t = &tok[i];
+        t->next = i + 1 < hdr->num_tokens ? t + 1 : nullptr;
+        t->loc = file->contents + r->loc;
+        t->len = r->len;
+        t->kind = (TokenKind)r->kind;
+        t->at_bol = r->flags & AT_BOL;
+        t->has_space = r->flags & HAS_SPACE;
+
+        switch (t->kind) {
+        case TK_NUM:
+            t->val = r->val;
+            break;
+        case TK_STR:
+            t->str = strs + r->val;
+            t->str_len = r->sym;
+            break;
+        case TK_IDENT:
+            t->sym = syms[r->sym];
+            break;
+        default:
+            t->sym = r->sym;
+        }
+    }
+
+    *guard = hdr->guard ? syms[hdr->guard - 1] : SYM_NONE;
+    free(syms);
+    return tok;
+}
+
+
+void store_cached_tokens(SourceFile *file, Token *tok, int guard)
+{
+    if (!cache_dir)
+        return;
+
+    size_t source_size = file->end - file->contents;
+    CacheHeader hdr = {};
+    memcpy(hdr.magic, cache_magic, sizeof(cache_magic));
+    hdr.version = CACHE_VERSION;
+    hdr.sym_ident = SYM_IDENT;
+    hdr.hash = hash_contents(file->contents, source_size);
+    hdr.source_size = source_size;
+    hdr.num_lines = file->num_lines;
+
+    // identifiers get indexes in order of first appearance
+    std::unordered_map<int, uint32_t> sym_index;
+    std::string syms, strs, recs;
+
+    for (Token *t = tok; t; t = t->next) {
+        CachedToken r = {};
+        r.loc = t->loc - file->contents;
+        r.len = t->len;
+        r.kind = t->kind;
+        r.flags = (t->at_bol ? AT_BOL : 0) | (t->has_space ? HAS_SPACE : 0);
+
+        switch (t->kind) {
+        case TK_NUM:
+            r.val = t->val;
+            break;
+        case TK_STR:
+            r.val = strs.size();
+            r.sym = t->str_len;
+            strs.append(t->str, t->str_len + 1);
+            break;
+        case TK_IDENT: {
+            auto ins = sym_index.emplace(t->sym, sym_index.size());
+            if (ins.second) {
+                char *name = sym_name(t->sym);
+                uint32_t len = strlen(name);
+                syms.append((char*)&len, sizeof(len));
+                syms.append(name, len);
+            }
+            r.sym = ins.first->second;
+            break;
+        }
+        default:
+            r.sym = t->sym;
+        }
+
+        recs.append((char*)&r, sizeof(r));
+        hdr.num_tokens++;
+    }
+
+    if (guard)
+        hdr.guard = sym_index.at(guard) + 1;
+    hdr.num_syms = sym_index.size();
+    hdr.syms_offset = sizeof(hdr) + recs.size() + sizeof(int32_t) * hdr.num_lines;
+    hdr.strs_offset = hdr.syms_offset + syms.size();
+    hdr.file_size = hdr.strs_offset + strs.size();
+
+    // write to a private name first, so readers never see a partial entry
+    char *path = cache_path(hdr.hash);
+    char *tmp = format("%s.%d", path, (int)getpid());
+    FILE *out = fopen(tmp, "wb");
+    if (!out) {
+        free(path);
+        free(tmp);
+        return;
+    }
+
+    fwrite(&hdr, sizeof(hdr), 1, out);
+    fwrite(recs.data(), 1, recs.size(), out);
+    fwrite(file->line_starts, sizeof(int32_t), hdr.num_lines, out);
+    fwrite(syms.data(), 1, syms.size(), out);
+    fwrite(strs.data(), 1, strs.size(), out);
+
+    if (fclose(out) == 0)
+        rename(tmp, path);
+    else
+        unlink(tmp);
+    free(path);
+    free(tmp);
+}
@@ -0,0 +1,20 @@
+#ifndef PCC_TOKEN_CACHE_H
+#define PCC_TOKEN_CACHE_H
+
+
+struct Token;
+struct SourceFile;
+
+// enables the on-disk token cache, kept in `dir`
+void set_token_cache_dir(char *dir);
+
+// returns the tokens of `file` from the cache, or NULL on a miss or if
+// the cache is disabled. *guard is set to the symbol id of the file's
+// include guard macro, or SYM_NONE.
+Token *load_cached_tokens(SourceFile *file, int *guard);
+
+// writes the tokens of `file` to the cache, if it's enabled
+void store_cached_tokens(SourceFile *file, Token *tok, int guard);
+
+
+#endif /* PCC_TOKEN_CACHE_H */
@@ -4,61 +4,113 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
 #include "tokenize.hpp"
-#include "type.hpp"
+#include "scan.hpp"
+#include "source.hpp"
 #include "utils/util.hpp"
+#include "utils/arena.hpp"
+#include "utils/parallel.hpp"
 
 
-static char *current_filename;
-static char *current_input;
+// backing store of every token and decoded string literal
+static Arena token_arena(1024 * 1024);
 
+// The lexer state is per thread, so that chunks of one file can be
+// tokenized in parallel (see tokenize_parallel()).
 
-// reports a error message like this:
+// the file whose line starts are being recorded
+static thread_local SourceFile *current_file;
+
+// flags for the next token
+static thread_local bool at_bol;
+static thread_local bool has_space;
+
+// where new tokens go
+static thread_local Arena *cur_arena = &token_arena;
+
+// true while tokenizing a chunk of a file on a worker thread
+static thread_local bool in_chunk;
+
+// thrown by error_at() in a chunk
+struct ChunkError {};
+
+// true while errors are thrown as DeferredError, see defer_errors()
+static thread_local bool deferring_errors;
+
+
+void defer_errors(bool on)
+{
+    deferring_errors = on;
+}
+
+
+// writes a error message like this:
 // foo.c:10: x = y + 1;
 //               ^ error message 
-static void verror_at(int line_no, char *loc, char *fmt, va_list ap)
+static void verror_at(FILE *out, char *loc, char *fmt, va_list ap)
 {
-    char *line_start = loc; // find the begin of line containing 'loc'
-    while (current_input < line_start && line_start[-1] != '\n') {
-        --line_start;
-    }
-    
-    char *line_end = loc;   // find the end of line containing 'loc'
-    while (*line_end != '\n') {
-        ++line_end;
+    SourceFile *file = find_source_file(loc);
+    if (!file) {
+        // not in any source buffer: there is no line to show
+        vfprintf(out, fmt, ap);
+        fprintf(out, "\n");
+        return;
     }
 
-    int indent = fprintf(stderr, "%s:%d: ", current_filename, line_no);
-    fprintf(stderr, "%.*s\n", (int)(line_end - line_start), line_start);
+    char *line_start = get_line_start(file, loc);
+    char *line_end = scanner.find_newline(loc);
+
+    int indent = fprintf(out, "%s:%d: ", file->name, get_line_no(file, loc));
+    fprintf(out, "%.*s\n", (int)(line_end - line_start), line_start);
 
     int pos = loc - line_start + indent;
-    fprintf(stderr, "%*s", pos, "");
-    fprintf(stderr, "^ ");
-    vfprintf(stderr, fmt, ap);
-    fprintf(stderr, "\n");
+    fprintf(out, "%*s", pos, "");
+    fprintf(out, "^ ");
+    vfprintf(out, fmt, ap);
+    fprintf(out, "\n");
+}
+
+
+// reports an error at `loc` and exits, or throws it if errors are deferred
+[[noreturn]] static void report_error(char *loc, char *fmt, va_list ap)
+{
+    if (deferring_errors) {
+        char *msg;
+        size_t len;
+        FILE *out = open_memstream(&msg, &len);
+        verror_at(out, loc, fmt, ap);
+        fclose(out);
+        throw DeferredError{msg};
+    }
+
+    verror_at(stderr, loc, fmt, ap);
+    exit(1);
 }
 
 
 void error_at(char *loc, char *fmt, ...)
 {
-    int line_no = 1;
-    for (char *p = current_input; p < loc; ++p)
-        if (*p == '\n'){
-            ++line_no;
-        }
-        
+    // a chunk may have been cut in the middle of a comment or literal,
+    // so whether this is a real error is decided when it's stitched
+    if (in_chunk)
+        throw ChunkError();
+
     va_list ap;
     va_start(ap, fmt);
-    verror_at(line_no, loc, fmt, ap);
-    exit(1);
+    report_error(loc, fmt, ap);
 }
 
 
 void error_tok(Token *tok, char *fmt, ...) {
   va_list ap;
   va_start(ap, fmt);
-  verror_at(tok->line_no, tok->loc, fmt, ap);
-  exit(1);
+  report_error(tok->loc, fmt, ap);
 }
 
 
@@ -87,31 +139,255 @@ bool consume(Token **rest, Token *tok, char *str) {
 }
 
 
+Token *skip(Token *tok, int sym)
+{
+    if (!equal(tok, sym))
+        error_tok(tok, "expected '%s'", sym_name(sym));
+    return tok->next;
+}
+
+
+bool consume(Token **rest, Token *tok, int sym) {
+    if (equal(tok, sym)) {
+        *rest = tok->next;
+        return true;
+    }
+    *rest = tok;
+    return false;
+}
+
+
+//
+// Symbol table
+//
+
+struct Spelling {
+    const char *name;
+    int len;
+    int sym;
+};
+
+#define X(id, str) {str, sizeof(str) - 1, id},
+static constexpr Spelling punctuators[] = { PCC_PUNCTUATORS(X) };
+static constexpr Spelling keywords[] = { PCC_KEYWORDS(X) };
+#undef X
+
+static constexpr int num_keywords = sizeof(keywords) / sizeof(*keywords);
+
+
+// Keywords are recognized with a perfect hash over the first character,
+// the last character and the length. The multipliers are searched for at
+// compile time, so adding a keyword to PCC_KEYWORDS is all it takes.
+static constexpr int KW_HASH_SIZE = 64;
+
+struct KeywordHash {
+    unsigned mul_first = 0;
+    unsigned mul_last = 0;
+    int8_t slot[KW_HASH_SIZE] = {};
+};
+
+static constexpr unsigned kw_hash(unsigned mul_first, unsigned mul_last,
+                                  const char *p, int len) {
+    return ((unsigned char)p[0] * mul_first +
+            (unsigned char)p[len - 1] * mul_last + len) % KW_HASH_SIZE;
+}
+
+static constexpr KeywordHash make_keyword_hash() {
+    for (unsigned m1 = 1; m1 < 256; ++m1) {
+        for (unsigned m2 = 1; m2 < 256; ++m2) {
+            KeywordHash h;
+            h.mul_first = m1;
+            h.mul_last = m2;
+            for (int i = 0; i < KW_HASH_SIZE; ++i)
+                h.slot[i] = -1;
+
+            bool ok = true;
+            for (int i = 0; i < num_keywords && ok; ++i) {
+                unsigned k = kw_hash(m1, m2, keywords[i].name, keywords[i].len);
+                ok = h.slot[k] == -1;
+                h.slot[k] = i;
+            }
+            if (ok)
+                return h;
+        }
+    }
+    return KeywordHash();
+}
+
+static constexpr KeywordHash keyword_hash = make_keyword_hash();
+static_assert(keyword_hash.mul_first != 0, "no perfect hash for PCC_KEYWORDS");
+
+
+// returns the symbol id of keyword p[0..len), or SYM_NONE if it isn't one
+static int keyword_sym(char *p, int len) {
+    if (len == 0)
+        return SYM_NONE;
+
+    unsigned k = kw_hash(keyword_hash.mul_first, keyword_hash.mul_last, p, len);
+    int i = keyword_hash.slot[k];
+    if (i >= 0 && keywords[i].len == len && !memcmp(keywords[i].name, p, len))
+        return keywords[i].sym;
+    return SYM_NONE;
+}
+
+
+// identifiers, as an open-addressing hash table of symbol ids plus
+// an array of spellings indexed by id - SYM_IDENT
+struct InternSlot {
+    uint32_t hash;
+    int sym; // SYM_NONE if the slot is empty
+};
+
+struct SymbolTable {
+    Arena arena;
+    InternSlot *slots;
+    int capacity;
+    char **names;
+    int *lens;
+    int count;
+};
+
+// the table behind every symbol id. a parallel tokenizer chunk fills
+// a private table instead and has its ids renumbered when it's stitched.
+static SymbolTable symbols;
+
+// where the lexer interns identifiers
+static thread_local SymbolTable *cur_symbols = &symbols;
+
+static uint32_t fnv_hash(char *p, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; ++i)
+        h = (h ^ (unsigned char)p[i]) * 16777619u;
+    return h;
+}
+
+static void grow_symbols(SymbolTable *t) {
+    int cap = t->capacity ? t->capacity * 2 : 1024;
+    InternSlot *slots = (InternSlot*)calloc(cap, sizeof(InternSlot));
+
+    for (int i = 0; i < t->capacity; ++i) {
+        InternSlot *old = &t->slots[i];
+        if (old->sym == SYM_NONE)
+            continue;
+        int j = old->hash & (cap - 1);
+        while (slots[j].sym != SYM_NONE)
+            j = (j + 1) & (cap - 1);
+        slots[j] = *old;
+    }
+
+    t->names = (char**)realloc(t->names, cap / 2 * sizeof(char*));
+    t->lens = (int*)realloc(t->lens, cap / 2 * sizeof(int));
+    free(t->slots);
+    t->slots = slots;
+    t->capacity = cap;
+}
+
+static void free_symbols(SymbolTable *t) {
+    free(t->slots);
+    free(t->names);
+    free(t->lens);
+    t->arena.release();
+}
+
+// returns SYM_IDENT plus the index of name[0..len) in `t`,
+// adding it the first time it's seen
+static int intern_in(SymbolTable *t, char *name, int len) {
+    // keep the load factor at or below 1/2
+    if ((t->count + 1) * 2 > t->capacity)
+        grow_symbols(t);
+
+    uint32_t h = fnv_hash(name, len);
+    int i = h & (t->capacity - 1);
+    for (;; i = (i + 1) & (t->capacity - 1)) {
+        InternSlot *slot = &t->slots[i];
+        if (slot->sym == SYM_NONE)
+            break;
+
+        int id = slot->sym - SYM_IDENT;
+        if (slot->hash == h && t->lens[id] == len &&
+            !memcmp(t->names[id], name, len))
+            return slot->sym;
+    }
+
+    t->names[t->count] = t->arena.strndup(name, len);
+    t->lens[t->count] = len;
+    t->slots[i] = {h, SYM_IDENT + t->count};
+    return SYM_IDENT + t->count++;
+}
+
+// returns the symbol id of the identifier or keyword name[0..len),
+// assigning a new id the first time a name is seen
+int intern(char *name, int len) {
+    int kw = keyword_sym(name, len);
+    if (kw)
+        return kw;
+    return intern_in(&symbols, name, len);
+}
+
+// returns the spelling of a symbol
+char *sym_name(int sym) {
+    static char chars[SYM_LAST_CHAR + 1][2];
+
+    if (sym <= SYM_LAST_CHAR) {
+        chars[sym][0] = sym;
+        return chars[sym];
+    }
+    if (sym < SYM_IDENT) {
+        for (const Spelling &s : punctuators)
+            if (s.sym == sym)
+                return (char*)s.name;
+        for (const Spelling &s : keywords)
+            if (s.sym == sym)
+                return (char*)s.name;
+    }
+    return symbols.names[sym - SYM_IDENT];
+}
+
+
 static Token *new_token(TokenKind kind, char *start, char *end)
 {
-    Token *tok = (Token*)calloc(1, sizeof(Token));
+    Token *tok = cur_arena->alloc<Token>();
     tok->kind = kind;
     tok->loc = start;
     tok->len = end - start;
+    tok->at_bol = at_bol;
+    tok->has_space = has_space;
+
+    at_bol = has_space = false;
     return tok;
 }
 
+
+Token *copy_token(Token *tok)
+{
+    Token *t = token_arena.alloc<Token>();
+    *t = *tok;
+    t->next = nullptr;
+    return t;
+}
+
+
+// returns an end-of-input marker positioned at tok
+Token *new_eof(Token *tok)
+{
+    Token *t = copy_token(tok);
+    t->kind = TK_EOF;
+    t->sym = SYM_NONE;
+    t->len = 0;
+    return t;
+}
+
 static bool startswith(char *p, char *q)
 {
     return strncmp(p, q, strlen(q)) == 0;
 }
 
 // returns true if c is valid as the first character of an identifier.
+// the rest of an identifier is matched by scanner.skip_ident().
 static bool is_ident1(char c) {
     return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
 }
 
-
-// returns true if c is valid as a non-first character of an identifier.
-static bool is_ident2(char c) {
-    return is_ident1(c) || ('0' <= c && c <= '9');
-}
-
 static int from_hex(char c) {
     if ('0' <= c && c <= '9')
         return c - '0';
@@ -120,37 +396,22 @@ static int from_hex(char c) {
     return c - 'A' + 10;
 }
 
-static int read_punct(char *p)
+// returns the length of the punctuator at p, or 0 if there isn't one,
+// and stores its symbol id to *sym
+static int read_punct(char *p, int *sym)
 {
-    static char *kw[] = {
-        "==", "!=", "<=", ">=", "->", "+=", "-=", "*=", "/=",
-        "++", "--", "%=", "&=", "|=", "^=", "&&", "||"
-    };
-    
-    for (int i = 0; i < sizeof(kw) / sizeof(*kw); ++i) {
-        if (startswith(p, kw[i]))
-            return strlen(kw[i]);        
+    for (const Spelling &s : punctuators) {
+        if (p[0] == s.name[0] && p[1] == s.name[1]) {
+            *sym = s.sym;
+            return 2;
+        }
     }
 
+    *sym = *p;
     return ispunct(*p) ? 1 : 0;
 }
 
 
-static bool is_keyword(Token *tok) {
-    static char *kw[] = {
-        "return", "if", "else", "for", "while", "int",
-        "sizeof", "char", "struct", "union", "short",
-        "long", "void", "typedef", "_Bool", "enum",
-        "static"};
-    
-    for (int i = 0; i < sizeof(kw) / sizeof(*kw); i++)
-        if (equal(tok, kw[i]))
-            return true;
-
-    return false;
-}
-
-
 static int read_escaped_char(char **new_pos, char *p) {
     if ('0' <= *p && *p <= '7') {
         // Read an octal number.
@@ -207,21 +468,25 @@ static int read_escaped_char(char **new_pos, char *p) {
 
 // Find a closing double-quote.
 static char *string_literal_end(char *p) {
-  char *start = p;
-  for (; *p != '"'; p++) {
-    if (*p == '\n' || *p == '\0')
-      error_at(start, "unclosed string literal");
-    if (*p == '\\')
-      p++;
-  }
-  return p;
+    char *start = p;
+    while (true) {
+        p = scanner.find_quote(p);
+        if (*p == '"')
+            return p;
+        if (*p == '\n' || *p == '\0')
+            error_at(start, "unclosed string literal");
+        // skip the escaped character, unless it's the end of input
+        if (p[1] == '\n')
+            add_line(current_file, p + 2);
+        p += p[1] ? 2 : 1;
+    }
 }
 
 
 
 static Token *read_string_literal(char *start) {
     char *end = string_literal_end(start + 1);
-    char *buf = (char*)calloc(1, end - start);
+    char *buf = (char*)cur_arena->allocate(end - start, 1);
     int len = 0;
 
     for (char *p = start + 1; p < end;) {
@@ -231,9 +496,11 @@ static Token *read_string_literal(char *start) {
             buf[len++] = *p++;
     }
 
+    buf[len] = '\0';
+
     Token *tok = new_token(TK_STR, start, end + 1);
-    tok->ty = array_of(ty_char, len + 1);
     tok->str = buf;
+    tok->str_len = len;
     return tok;
 }
 
@@ -260,6 +527,20 @@ static Token *read_char_literal(char *start) {
 
 
 static Token* read_int_literal(char *start) {
+    // fast path for decimal literals short enough not to overflow
+    if (*start != '0') {
+        char *end = scanner.skip_digits(start);
+        if (end - start <= 18 && !isalnum(*end)) {
+            long val = 0;
+            for (char *p = start; p < end; ++p)
+                val = val * 10 + (*p - '0');
+
+            Token *tok = new_token(TK_NUM, start, end);
+            tok->val = val;
+            return tok;
+        }
+    }
+
     char *p = start;
     int base = 10;
     
@@ -286,59 +567,44 @@ static Token* read_int_literal(char *start) {
 
 
 
-static void convert_keywords(Token *tok) {
-    for (Token *t = tok; t->kind != TK_EOF; t = t->next)
-        if (is_keyword(t))
-            t->kind = TK_KEYWORD;
-}
-
-
-static void add_line_numbers(Token *tok) {
-    char *p = current_input;
-    int n = 1;
-    do {
-        if(p == tok->loc) {
-            tok->line_no = n;
-            tok = tok->next;
-        }
-        if (*p == '\n')
-            ++n;
-
-    }while(*p++);
-}
-
-
-
-static Token *tokenize(char *filename, char *p)
+// tokenizes from `p` until the first token boundary at or past `limit`
+// (or the end of input), appending the tokens to `cur`. returns the last
+// token appended and stores where it stopped to *end.
+static Token *tokenize_range(char *p, char *limit, Token *cur, char **end)
 {
-    current_filename = filename;
-    current_input = p;
-    Token head = {};
-    Token *cur = &head;
+    SourceFile *file = current_file;
 
-    while(*p)
+    while(p < limit && *p)
     {
         // skip line comments
         if (startswith(p, "//")) {
-            p += 2;
-            while (*p != '\n'){
-                ++p;
-            }
+            p = scanner.find_newline(p + 2);
+            has_space = true;
             continue;
         }
 
         // skip block comments
         if (startswith(p, "/*")) {
-            char *q = strstr(p + 2, "*/");
+            char *q = scanner.find_comment_end(p + 2);
             if (!q)
                 error_at(p, "unclosed block comment");
+            for (char *r = scanner.find_newline(p + 2); r < q; r = scanner.find_newline(r))
+                add_line(file, ++r);
             p = q + 2;
+            has_space = true;
             continue;
         }
 
+        if (*p == '\n') {
+            add_line(file, ++p);
+            at_bol = true;
+            has_space = false;
+            continue;
+        }
 
         if(isspace(*p)) {
-            ++p;
+            p = scanner.skip_space(p + 1);
+            has_space = true;
             continue;
         }        
 
@@ -365,17 +631,21 @@ static Token *tokenize(char *filename, char *p)
         // identifier or keyword
         if(is_ident1(*p)) {
             char *start = p;
-            do {
-                ++p;
-            }while(is_ident2(*p));
-            cur = cur->next = new_token(TK_IDENT, start, p);
+            p = scanner.skip_ident(p + 1);
+            int sym = keyword_sym(start, p - start);
+            if (!sym)
+                sym = intern_in(cur_symbols, start, p - start);
+            cur = cur->next = new_token(sym < SYM_IDENT ? TK_KEYWORD : TK_IDENT, start, p);
+            cur->sym = sym;
             continue;
         }
 
         // punctuators
-        int punct_len = read_punct(p);
+        int sym;
+        int punct_len = read_punct(p, &sym);
         if(punct_len) {
             cur = cur->next = new_token(TK_PUNCT, p, p + punct_len);
+            cur->sym = sym;
             p += cur->len;
             continue;
         }
@@ -383,25 +653,217 @@ static Token *tokenize(char *filename, char *p)
         error_at(p, "invalid token");
     }
 
-    cur = cur->next = new_token(TK_EOF, p, p);
-    add_line_numbers(head.next);
-    convert_keywords(head.next);
-    return head.next;
+    *end = p;
+    return cur;
 }
 
 
-static char *read_file(char *path) {
-    FILE *fp;
+//
+// Parallel tokenization
+//
+// A large file is cut into chunks at line starts, and the chunks are
+// tokenized on a pool of threads, each into its own arena, line table and
+// symbol table. A chunk assumes that it starts outside any comment or
+// literal. That's checked when the chunks are stitched together in order:
+// the chunk before must have stopped exactly at its start. If it didn't,
+// say because a block comment spans the cut, the chunk is tokenized again
+// from where the previous one stopped. Each chunk's identifiers are added
+// to the global symbol table in order of first appearance, chunk by chunk,
+// so every token ends up exactly as the sequential tokenizer makes it.
+//
+
+static int tokenize_jobs = 1;
+
+// files smaller than two chunks are tokenized sequentially
+static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+struct Chunk {
+    char *start;
+    char *limit;
+    char *end;          // where tokenizing stopped
+    Token head;
+    Token *last;
+    bool at_bol;        // flags for the token after the chunk
+    bool has_space;
+    bool failed;        // hit an error; retried if it really started at `start`
+    bool retried;       // tokenized again by the stitcher
+    SourceFile lines;   // line starts crossed
+    SymbolTable symbols; // identifiers, with chunk-local ids
+    int *sym_map;       // chunk-local id - SYM_IDENT -> global id
+    Arena arena;
+};
+
+// arenas of stitched chunks, freed by free_tokens()
+static std::vector<Arena> chunk_arenas;
+
+
+void set_tokenize_jobs(int n) {
+    tokenize_jobs = n;
+}
+
 
-    if (strcmp(path, "-") == 0) {
-        fp = stdin;
+// returns the first occurrence of c1 followed by c2 in [p, end), or NULL
+static char *find_pair(char *p, char *end, char c1, char c2) {
+    for (; p + 1 < end; ++p)
+        if (p[0] == c1 && p[1] == c2)
+            return p;
+    return nullptr;
+}
+
+// returns a line start at or after `p` to cut the file at. the cut is
+// only a guess, but a quick look at the next few lines avoids the usual
+// ways of guessing wrong: lines joined by a backslash (only legal inside
+// a string literal here) aren't cut apart, and a line that closes a block
+// comment it didn't open is taken as being inside that comment.
+static char *split_point(char *p, char *end) {
+    char *cut = nullptr;
+
+    for (int i = 0; i < 64 && p < end; ++i) {
+        char *nl = scanner.find_newline(p);
+        if (nl >= end)
+            break;
+
+        char *close = find_pair(p, nl, '*', '/');
+        char *open = find_pair(p, nl, '/', '*');
+        if (close && (!open || close < open))
+            return nl + 1;
+
+        if (!cut && nl[-1] != '\\')
+            cut = nl + 1;
+        p = nl + 1;
     }
-    else {
-        fp = fopen(path, "r");
-        if (!fp)
-            error("cannot open %s: %s", path, strerror(errno));
+    return cut ? cut : end;
+}
+
+
+static void tokenize_chunk(Chunk *c, char *contents) {
+    c->lines.contents = contents;
+    current_file = &c->lines;
+    cur_arena = &c->arena;
+    cur_symbols = &c->symbols;
+    in_chunk = true;
+    at_bol = true;
+    has_space = false;
+
+    try {
+        c->last = tokenize_range(c->start, c->limit, &c->head, &c->end);
+        c->at_bol = at_bol;
+        c->has_space = has_space;
+    } catch (...) {
+        c->failed = true;
+    }
+
+    current_file = nullptr;
+    cur_arena = &token_arena;
+    cur_symbols = &symbols;
+    in_chunk = false;
+}
+
+
+static Token *tokenize_parallel(SourceFile *file) {
+    char *contents = file->contents;
+    size_t size = file->end - contents;
+    int n = std::min(size / MIN_CHUNK_SIZE, (size_t)tokenize_jobs * 4);
+
+    std::vector<Chunk> chunks(n);
+    char *p = contents;
+    for (int i = 0; i < n; ++i) {
+        chunks[i].start = p;
+        if (i + 1 < n)
+            p = split_point(std::max(p, contents + size * (i + 1) / n), file->end);
+        else
+            p = file->end;
+        chunks[i].limit = p;
+    }
+
+    parallel_for(n, tokenize_jobs, [&](int i) {
+        tokenize_chunk(&chunks[i], contents);
+    });
+
+    // stitch the chunks together in order
+    Token head = {};
+    Token *cur = &head;
+    p = contents;
+    bool bol = true, space = false;
+
+    for (Chunk &c : chunks) {
+        if (c.start != p || c.failed) {
+            // the chunk wasn't cut where a token starts, or it found an
+            // error; redo it here, where errors are reported as usual
+            c.retried = true;
+            current_file = file;
+            at_bol = bol;
+            has_space = space;
+            cur = tokenize_range(p, c.limit, cur, &p);
+            bol = at_bol;
+            space = has_space;
+            continue;
+        }
+
+        for (int i = 0; i < c.lines.num_lines; ++i)
+            add_line(file, contents + c.lines.line_starts[i]);
+
+        c.sym_map = (int*)malloc(sizeof(int) * (c.symbols.count + 1));
+        for (int i = 0; i < c.symbols.count; ++i)
+            c.sym_map[i] = intern_in(&symbols, c.symbols.names[i], c.symbols.lens[i]);
+
+        if (c.head.next) {
+            cur->next = c.head.next;
+            cur = c.last;
+        }
+        p = c.end;
+        bol = c.at_bol;
+        space = c.has_space;
+        chunk_arenas.push_back(std::move(c.arena));
     }
 
+    at_bol = bol;
+    has_space = space;
+    cur->next = new_token(TK_EOF, p, p);
+
+    // give identifiers their global ids
+    parallel_for(n, tokenize_jobs, [&](int i) {
+        Chunk *c = &chunks[i];
+        if (c->retried || !c->head.next)
+            return;
+        for (Token *t = c->head.next;; t = t->next) {
+            if (t->kind == TK_IDENT)
+                t->sym = c->sym_map[t->sym - SYM_IDENT];
+            if (t == c->last)
+                break;
+        }
+    });
+
+    for (Chunk &c : chunks) {
+        free(c.lines.line_starts);
+        free(c.sym_map);
+        free_symbols(&c.symbols);
+    }
+    current_file = nullptr;
+    return head.next;
+}
+
+
+Token *tokenize(SourceFile *file)
+{
+    if (tokenize_jobs > 1 && (size_t)(file->end - file->contents) >= 2 * MIN_CHUNK_SIZE)
+        return tokenize_parallel(file);
+
+    current_file = file;
+    at_bol = true;
+    has_space = false;
+
+    Token head = {};
+    char *end;
+    Token *cur = tokenize_range(file->contents, file->end, &head, &end);
+    cur->next = new_token(TK_EOF, end, end);
+    return head.next;
+}
+
+
+
+// reads a stream to the end into a heap buffer terminated by "\n\0".
+static char *read_stream(FILE *fp, int *size) {
     char *buf;
     size_t buflen;
     FILE *out = open_memstream(&buf, &buflen);
@@ -415,18 +877,100 @@ static char *read_file(char *path) {
         fwrite(buf2, 1, n, out);
     }
 
-    if (fp != stdin)
-        fclose(fp);
-
     fflush(out);
     // ensure the last line terminated with '\n'
     if(buflen == 0 || buf[buflen - 1] != '\n')
         fputc('\n', out);
+    fflush(out);
+    *size = buflen;
     fputc('\0', out);
     fclose(out);
-    return buf;   
+    return buf;
 }
 
+
+// maps a regular file of `size` bytes (size > 0) privately into memory,
+// followed by at least two zero bytes. the pages past the end of the file
+// come from an anonymous reservation, so the '\n' we may have to append
+// only dirties a copy-on-write page and never touches the file.
+// returns NULL if the file can't be mapped.
+static char *map_file(int fd, size_t size, int *len) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t maplen = (size + 2 + page - 1) / page * page;
+
+    char *buf = (char*)mmap(nullptr, maplen, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED)
+        return nullptr;
+
+    if (mmap(buf, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+             fd, 0) == MAP_FAILED) {
+        munmap(buf, maplen);
+        return nullptr;
+    }
+
+    // ensure the last line terminated with '\n'; the bytes after it
+    // are already zero
+    *len = size;
+    if (buf[size - 1] != '\n')
+        buf[(*len)++] = '\n';
+    return buf;
+}
+
+
+// returns the contents of a file followed by '\0', and its length
+// without the '\0' in *size
+static char *read_file(char *path, int *size) {
+    if (strcmp(path, "-") == 0)
+        return read_stream(stdin, size);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        error("cannot open %s: %s", path, strerror(errno));
+
+    // regular files are mapped, anything else (pipes, devices) is streamed
+    struct stat st;
+    char *buf = nullptr;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        buf = map_file(fd, st.st_size, size);
+
+    if (!buf) {
+        FILE *fp = fdopen(fd, "r");
+        if (!fp)
+            error("cannot open %s: %s", path, strerror(errno));
+        buf = read_stream(fp, size);
+        fclose(fp);
+        return buf;
+    }
+
+    close(fd);
+    return buf;
+}
+
+// reads a file and registers it as an input file
+SourceFile *read_source_file(char *path) {
+    int size;
+    char *contents = read_file(path, &size);
+    return new_input_file(path, contents, size);
+}
+
+
 Token *tokenize_file(char *path) {
-    return tokenize(path, read_file(path));
+    return tokenize(read_source_file(path));
+}
+
+
+// returns `n` zero-filled tokens, adjacent in memory
+Token *new_tokens(int n) {
+    Token *tok = (Token*)token_arena.allocate(sizeof(Token) * n, alignof(Token));
+    memset(tok, 0, sizeof(Token) * n);
+    return tok;
+}
+
+
+// frees all tokens and string literal contents at once. nothing may
+// refer to a token (e.g. Node::tok) or to Token::str afterwards.
+void free_tokens() {
+    token_arena.release();
+    chunk_arenas.clear();
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 #include <stdint.h>
 
 
-enum TokenKind
+enum TokenKind : uint8_t
 {
     TK_PUNCT,   // Punctuators
     TK_IDENT,   // Identifiers
@@ -15,27 +15,94 @@ enum TokenKind
 };
 
 
-struct Type;
+// Multi-character punctuators and their symbol ids
+#define PCC_PUNCTUATORS(X) \
+    X(P_EQ, "==") X(P_NE, "!=") X(P_LE, "<=") X(P_GE, ">=") \
+    X(P_ARROW, "->") X(P_INC, "++") X(P_DEC, "--") \
+    X(P_LOGAND, "&&") X(P_LOGOR, "||") \
+    X(P_ADD_ASSIGN, "+=") X(P_SUB_ASSIGN, "-=") X(P_MUL_ASSIGN, "*=") \
+    X(P_DIV_ASSIGN, "/=") X(P_MOD_ASSIGN, "%=") X(P_AND_ASSIGN, "&=") \
+    X(P_OR_ASSIGN, "|=") X(P_XOR_ASSIGN, "^=") X(P_HASHHASH, "##")
+
+// Keywords and their symbol ids
+#define PCC_KEYWORDS(X) \
+    X(KW_RETURN, "return") X(KW_IF, "if") X(KW_ELSE, "else") \
+    X(KW_FOR, "for") X(KW_WHILE, "while") X(KW_SIZEOF, "sizeof") \
+    X(KW_VOID, "void") X(KW_BOOL, "_Bool") X(KW_CHAR, "char") \
+    X(KW_SHORT, "short") X(KW_INT, "int") X(KW_LONG, "long") \
+    X(KW_STRUCT, "struct") X(KW_UNION, "union") X(KW_ENUM, "enum") \
+    X(KW_TYPEDEF, "typedef") X(KW_STATIC, "static")
+
+// Symbol ids. Every identifier, keyword and punctuator is interned by
+// the tokenizer, so comparing two spellings is comparing two ids.
+// A single-character punctuator's id is the character itself, which
+// lets the parser write equal(tok, '('). Ids from SYM_IDENT onward are
+// handed out to identifiers in order of first appearance.
+enum : int32_t
+{
+    SYM_NONE = 0,       // numbers and string literals
+    SYM_LAST_CHAR = 127, // 1..127 are single-character punctuators
+#define X(id, str) id,
+    PCC_PUNCTUATORS(X)
+    PCC_KEYWORDS(X)
+#undef X
+    SYM_IDENT
+};
+
+
+// Tokens are allocated back to back from an arena, so `next` is almost
+// always the adjacent token. Keep this struct small.
+struct Hideset;
 
 struct Token
 {
-    TokenKind kind;
     Token *next;
-    int64_t val; // used if kind is TK_NUM
     char *loc;
-    int len;
-    Type *ty;    // used if TK_STR
-    char *str;   // string literal contents
-    int line_no; // line number
+    union {
+        int64_t val;      // used if kind is TK_NUM
+        char *str;        // string literal contents, used if kind is TK_STR
+        Hideset *hideset; // macros not to expand, used if TK_IDENT or TK_KEYWORD
+    };
+    int32_t len;
+    int32_t sym;     // symbol id, SYM_NONE for TK_NUM and TK_STR
+    int32_t str_len; // length of str without the terminating '\0'
+    TokenKind kind;
+    bool at_bol;     // true if this token is at beginning of line
+    bool has_space;  // true if this token follows a space character
 };
 
 
 void error_at(char *loc, char *fmt, ...);
 void error_tok(Token *tok, char *fmt, ...);
+
+// Thrown by error_at() and error_tok(), instead of printing the message
+// and exiting, on a thread that has called defer_errors(true).
+struct DeferredError
+{
+    char *msg; // the message as it would have been printed
+};
+void defer_errors(bool on);
 bool equal(Token *tok, char *op);
 Token *skip(Token *tok, char *op);
 bool consume(Token **rest, Token *tok, char *str);
+
+inline bool equal(Token *tok, int sym) { return tok->sym == sym; }
+Token *skip(Token *tok, int sym);
+bool consume(Token **rest, Token *tok, int sym);
+
+int intern(char *name, int len);
+char *sym_name(int sym);
+struct SourceFile;
+
+Token *tokenize(SourceFile *file);
+// tokenize large files on up to n threads
+void set_tokenize_jobs(int n);
+SourceFile *read_source_file(char *path);
 Token *tokenize_file(char *filename);
+Token *new_tokens(int n);
+Token *copy_token(Token *tok);
+Token *new_eof(Token *tok);
+void free_tokens();
 
 
 
@@ -1,8 +1,14 @@
+#include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <mutex>
 #include <string>
 #include "type.hpp"
 #include "parse.hpp"
 #include "tokenize.hpp"
+#include "utils/arena.hpp"
+#include "utils/util.hpp"
 
 
 
@@ -29,40 +35,159 @@ bool is_integer(Type *ty) {
            k == TY_INT || k == TY_LONG || k == TY_ENUM;
 }
 
-    
-Type *copy_type(Type *ty) {
-    Type *ret = (Type*)calloc(1, sizeof(Type));
-    *ret = *ty;
-    return ret;
+
+
+//
+// Derived types are hash-consed in an open-addressing table keyed by
+// everything that tells two of them apart. Function bodies may be
+// parsed on several threads at once, so the table has a lock.
+//
+
+static std::mutex type_lock;
+static Arena type_arena;
+static Type **type_table;
+static int type_capacity;
+static int num_types;
+
+static uint64_t hash_type(Type *ty) {
+    uint64_t h = ty->kind;
+    auto mix = [&](uint64_t v) { h = (h ^ v) * 0x100000001b3ull; };
+    mix((uintptr_t)ty->base);
+    mix(ty->array_len);
+    mix((uintptr_t)ty->return_ty);
+    for (int i = 0; i < ty->num_params; ++i)
+        mix((uintptr_t)ty->params[i]);
+    return h ^ (h >> 29);
 }
 
-Type *pointer_to(Type *base) {
-    Type *ty = new_type(TY_PTR, 8, 8);
-    ty->base = base;
-    return ty;
+static bool same_derived_type(Type *a, Type *b) {
+    if (a->kind != b->kind || a->base != b->base ||
+        a->array_len != b->array_len || a->return_ty != b->return_ty ||
+        a->num_params != b->num_params)
+        return false;
+
+    for (int i = 0; i < a->num_params; ++i)
+        if (a->params[i] != b->params[i])
+            return false;
+    return true;
 }
 
+static void grow_type_table() {
+    int cap = type_capacity ? type_capacity * 2 : 1024;
+    Type **table = (Type**)calloc(cap, sizeof(Type*));
 
-Type *func_type(Type *return_ty) {
-    Type *ty = (Type*)calloc(1, sizeof(Type));
-    ty->kind = TY_FUNC;
-    ty->return_ty = return_ty;
+    for (int i = 0; i < type_capacity; ++i) {
+        Type *ty = type_table[i];
+        if (!ty)
+            continue;
+        int j = hash_type(ty) & (cap - 1);
+        while (table[j])
+            j = (j + 1) & (cap - 1);
+        table[j] = ty;
+    }
+
+    free(type_table);
+    type_table = table;
+    type_capacity = cap;
+}
+
+// returns the unique type equal to `key`, making a copy of `key`
+// the first time it's seen
+static Type *intern_type(Type *key) {
+    std::lock_guard<std::mutex> guard(type_lock);
+
+    // keep the load factor at or below 1/2
+    if ((num_types + 1) * 2 > type_capacity)
+        grow_type_table();
+
+    int i = hash_type(key) & (type_capacity - 1);
+    for (; type_table[i]; i = (i + 1) & (type_capacity - 1))
+        if (same_derived_type(type_table[i], key))
+            return type_table[i];
+
+    Type *ty = type_arena.alloc<Type>();
+    *ty = *key;
+    if (key->num_params) {
+        ty->params = (Type**)type_arena.allocate(sizeof(Type*) * key->num_params,
+                                                 alignof(Type*));
+        memcpy(ty->params, key->params, sizeof(Type*) * key->num_params);
+    }
+
+    type_table[i] = ty;
+    num_types++;
     return ty;
 }
 
 
+Type *pointer_to(Type *base) {
+    Type key(TY_PTR, 8, 8);
+    key.base = base;
+    return intern_type(&key);
+}
+
+
+Type *func_type(Type *return_ty, Type **params, int num_params) {
+    Type key(TY_FUNC, 0, 0);
+    key.return_ty = return_ty;
+    key.params = params;
+    key.num_params = num_params;
+    return intern_type(&key);
+}
+
+
 Type *array_of(Type *base, int len) {
-    Type *ty = new_type(TY_ARRAY, base->size * len, base->align);
-    ty->base = base;
-    ty->array_len = len;
-    return ty;
+    Type key(TY_ARRAY, base->size * len, base->align);
+    key.base = base;
+    key.array_len = len;
+    return intern_type(&key);
 }
 
+
 Type *enum_type() {
     return new_type(TY_ENUM, 4, 4);
 }
 
 
+//
+// Members of a struct or union are found by the symbol id of their name
+// in an open-addressing table, built once the type is defined. Symbol
+// ids are dense, so the id itself serves as the hash.
+//
+
+void set_members(Type *ty, Member *members, int num_members) {
+    for (int i = 0; i + 1 < num_members; ++i)
+        members[i].next = &members[i + 1];
+    ty->members = num_members ? members : nullptr;
+    ty->num_members = num_members;
+
+    int cap = 8;
+    while (cap < num_members * 2)
+        cap *= 2;
+    ty->member_index = (Member**)calloc(cap, sizeof(Member*));
+    ty->member_mask = cap - 1;
+
+    for (int i = 0; i < num_members; ++i) {
+        Member *mem = &members[i];
+        int j = mem->name->sym & ty->member_mask;
+        while (ty->member_index[j] && ty->member_index[j]->name->sym != mem->name->sym)
+            j = (j + 1) & ty->member_mask;
+        // the first of two members with one name hides the other
+        if (!ty->member_index[j])
+            ty->member_index[j] = mem;
+    }
+}
+
+Member *find_member(Type *ty, int sym) {
+    if (!ty->member_index)
+        return nullptr;
+
+    for (int j = sym & ty->member_mask; ty->member_index[j]; j = (j + 1) & ty->member_mask)
+        if (ty->member_index[j]->name->sym == sym)
+            return ty->member_index[j];
+    return nullptr;
+}
+
+
 static Type *get_common_type(Type *ty1, Type *ty2) {
     if(ty1->base)
         return pointer_to(ty1->base);
@@ -89,26 +214,36 @@ static void usual_arith_conversion(Node **lhs, Node **rhs) {
 }
 
 
-void add_type(Node *node) {
-    if (!node || node->ty) {
-        return;
+// true if the operands of `node` are typed
+static bool operands_typed(Node *node) {
+    switch (node->kind)
+    {
+    case ND_FUNCALL:
+        for (Node *n = node->args; n; n = n->next) {
+            if (!n->ty)
+                return false;
+        }
+        return true;
+    case ND_NEG:
+    case ND_NOT:
+    case ND_BITNOT:
+    case ND_ADDR:
+    case ND_DEREF:
+    case ND_MEMBER:
+        return node->lhs->ty;
+    default:
+        return !is_binary(node->kind) || (node->lhs->ty && node->rhs->ty);
     }
+}
 
-    add_type(node->lhs);
-    add_type(node->rhs);
-    add_type(node->cond);
-    add_type(node->then);
-    add_type(node->els);
-    add_type(node->init);
-    add_type(node->inc);
-
-    for (Node *n = node->body; n; n = n->next) {
-        add_type(n);
-    }
 
-    for (Node *n = node->args; n; n = n->next) {
-        add_type(n);
-    }
+// Sets the type of an expression node. Every node is typed once, by the
+// parser as it builds the node, and operands are built before the nodes
+// that use them, so this never has to descend into the tree. Statements
+// have no type.
+void add_type(Node *node) {
+    assert(!node->ty && "node typed twice");
+    assert(operands_typed(node) && "operand built untyped");
 
     switch (node->kind)
     {
@@ -134,6 +269,7 @@ void add_type(Node *node) {
         return;
     }
     case ND_ASSIGN:
+    case ND_OP_ASSIGN:
         if(node->lhs->ty->kind == TY_ARRAY) {
             error_tok(node->lhs->tok, "not an lvalue");
         }
@@ -150,7 +286,7 @@ void add_type(Node *node) {
         node->ty = ty_int;
         return;
     case ND_FUNCALL:
-        node->ty = ty_long;
+        node->ty = node->func_ty->return_ty;
         return;
     case ND_NOT:
     case ND_LOGAND:
@@ -199,6 +335,9 @@ void add_type(Node *node) {
         }
         error_tok(node->tok, "statement expression returning void is not supported");
         return;
+    case ND_OLD_VALUE:
+        // typed by the parser, which knows what is assigned to
+        unreachable();
     }
 }
 
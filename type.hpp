@@ -32,6 +32,11 @@ typedef enum
     TY_UNION
 } TypeKind;
 
+// Derived types (pointers, arrays and functions) are unique: building
+// the same one twice yields the same Type, so two of them are the same
+// type exactly when they are the same pointer. Types are shared, and
+// must not be modified once built. Names of declared entities are kept
+// by the parser, never in a Type.
 struct Type
 {
     TypeKind kind;
@@ -41,26 +46,27 @@ struct Type
     // pointer or array
     Type *base;
 
-    // declaration
-    Token *name;
-
     int array_len;
 
-    // struct
+    // struct or union: an array of members in declaration order, also
+    // linked through Member::next, and an index of them by name
     Member *members;
+    int num_members;
+    Member **member_index;
+    int member_mask;
 
     // function type
     Type *return_ty;
-    Type *params;
-    Type *next;
+    Type **params;
+    int num_params;
 
     Type() = default;
 
     Type(TypeKind kind, int size, int align) :
         kind(kind), size(size), align(align),
-        base(nullptr), name(nullptr), array_len(0),
-        members(nullptr), return_ty(nullptr),
-        params(nullptr), next(nullptr) {}
+        base(nullptr), array_len(0), members(nullptr), num_members(0),
+        member_index(nullptr), member_mask(0),
+        return_ty(nullptr), params(nullptr), num_params(0) {}
 };
 
 
@@ -73,11 +79,12 @@ extern Type *ty_short;
 
 
 bool is_integer(Type *ty);
-Type *copy_type(Type *ty);
 Type *pointer_to(Type *base);
-Type *func_type(Type *return_ty);
+Type *func_type(Type *return_ty, Type **params, int num_params);
 Type *array_of(Type *base, int size);
 Type *enum_type();
+void set_members(Type *ty, Member *members, int num_members);
+Member *find_member(Type *ty, int sym);
 void add_type(Node *node);
 
 
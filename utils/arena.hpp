@@ -0,0 +1,134 @@
+#ifndef PCC_UTILS_ARENA_H
+#define PCC_UTILS_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+
+/**
+ * @class Arena
+ * @brief A bump allocator that releases everything at once.
+ *
+ * Memory is carved out of large chunks in allocation order, so objects
+ * allocated one after another are adjacent in memory. Individual objects
+ * are never freed; release() (or the destructor) frees every chunk.
+ * Only trivially destructible objects should live in an arena.
+ */
+class Arena {
+private:
+    struct Chunk {
+        Chunk *prev;
+        size_t size;
+    };
+
+    static constexpr size_t default_chunk_size = 64 * 1024;
+
+    Chunk *chunks = nullptr;
+    char *cur = nullptr;
+    char *end = nullptr;
+    size_t chunk_size;
+    size_t used = 0;
+
+    void *grow(size_t size, size_t align) {
+        size_t need = sizeof(Chunk) + size + align;
+        size_t cap = need > chunk_size ? need : chunk_size;
+
+        Chunk *c = (Chunk*)malloc(cap);
+        if (!c)
+            throw std::bad_alloc();
+        c->prev = chunks;
+        c->size = cap;
+        chunks = c;
+
+        cur = (char*)(c + 1);
+        end = (char*)c + cap;
+        return allocate(size, align);
+    }
+
+public:
+    explicit Arena(size_t chunk_size = default_chunk_size)
+        : chunk_size(chunk_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other)
+        : chunks(other.chunks), cur(other.cur), end(other.end),
+          chunk_size(other.chunk_size), used(other.used) {
+        other.chunks = nullptr;
+        other.cur = other.end = nullptr;
+        other.used = 0;
+    }
+
+    ~Arena() { release(); }
+
+    /**
+     * @brief Allocate \p size uninitialized bytes aligned to \p align
+     *
+     * @param size
+     * @param align must be a power of two
+     * @return void*
+     */
+    void *allocate(size_t size, size_t align = alignof(max_align_t)) {
+        uintptr_t p = ((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1);
+        if (!cur || p + size > (uintptr_t)end)
+            return grow(size, align);
+
+        cur = (char*)(p + size);
+        used += size;
+        return (void*)p;
+    }
+
+    /**
+     * @brief Allocate a zero-filled T
+     *
+     * @tparam T a trivially destructible type
+     * @return T*
+     */
+    template <typename T>
+    T *alloc() {
+        void *p = allocate(sizeof(T), alignof(T));
+        memset(p, 0, sizeof(T));
+        return (T*)p;
+    }
+
+    /**
+     * @brief Copy \p len bytes of \p s into the arena and NUL-terminate it
+     *
+     * @param s
+     * @param len
+     * @return char*
+     */
+    char *strndup(const char *s, size_t len) {
+        char *p = (char*)allocate(len + 1, 1);
+        memcpy(p, s, len);
+        p[len] = '\0';
+        return p;
+    }
+
+    /**
+     * @brief Number of bytes handed out since construction or the last release
+     *
+     * @return size_t
+     */
+    size_t bytes_used() const { return used; }
+
+    /**
+     * @brief Free every chunk. All memory allocated from the arena becomes invalid.
+     */
+    void release() {
+        while (chunks) {
+            Chunk *prev = chunks->prev;
+            free(chunks);
+            chunks = prev;
+        }
+        cur = end = nullptr;
+        used = 0;
+    }
+};
+
+
+#endif /* PCC_UTILS_ARENA_H */
@@ -2,6 +2,7 @@
 #define PCC_UTILS_ILIST_H
 
 #include <memory>
+#include <type_traits>
 #include "iterator/iterator_adaptor.hpp"
 #include "type_traits.hpp"
 #include "iterator/to_address.hpp"
@@ -15,15 +16,17 @@ class ilist;
  * @class ilist_node
  * @brief Node for the intrusive list.
  * 
- * A node class for ilist. Friend of class ilist.
+ * A node class for ilist. Friend of class ilist. The list's own
+ * sentinel is a bare \c ilist_node, so links point to nodes rather
+ * than to \p Derived objects.
  * 
  * @tparam Derived Data type of the node.
  */
 template <typename Derived>
 class ilist_node {
     friend class ilist<Derived>;
-    Derived* next;
-    Derived* prev;
+    ilist_node* next;
+    ilist_node* prev;
 };
 
 
@@ -36,17 +39,24 @@ class ilist_node {
 template <typename T>
 class ilist {
 private:
+    using node_type = ilist_node<T>;
+
+    template<typename U>
+    using node_of = std::conditional_t<std::is_const_v<U>, const node_type, node_type>;
+
     template<typename U>
-    class ilist_iterator: public iterator_adaptor<ilist_iterator<U>, U*, U, std::bidirectional_iterator_tag> {
+    class ilist_iterator: public iterator_adaptor<ilist_iterator<U>, node_of<U>*, U, std::bidirectional_iterator_tag> {
     private:
         friend class iterator_core_access;
-        using super_t = iterator_adaptor<ilist_iterator<U>, U*, U, std::bidirectional_iterator_tag>;
+        using super_t = iterator_adaptor<ilist_iterator<U>, node_of<U>*, U, std::bidirectional_iterator_tag>;
 
     public:
         using pointer = typename super_t::pointer;
+        using reference = typename super_t::reference;
 
         ilist_iterator() = default;
         ilist_iterator(pointer node) : super_t(node) {}
+        explicit ilist_iterator(node_of<U>* node) : super_t(node) {}
 
         template<typename OtherU>
         ilist_iterator(const ilist_iterator<OtherU>& other): super_t(other.base()) {}
@@ -58,6 +68,7 @@ private:
         }
     
     private:
+        reference dereference() const { return static_cast<reference>(*this->base()); }
         void increment() { this->base_reference() = this->base()->next; }
         void decrement() { this->base_reference() = this->base()->prev; }
     };
@@ -77,23 +88,17 @@ public:
     using difference_type = iterator_difference_t<iterator>;
 
 private:
-    pointer blank;
+    node_type blank; ///< The sentinel, which end() points to.
     size_type count;
-    std::allocator<T> alloca;
-
-    void delete_node(pointer node) {
-        node->~value_type();
-        alloca.deallocate(node, 1);
-    }
 
 public:
     /**
      * @brief Construct a new ilist object
      * 
      */
-    ilist(): blank(alloca.allocate(1)), count(0) {
-        blank->next = blank;
-        blank->prev = blank;
+    ilist(): count(0) {
+        blank.next = &blank;
+        blank.prev = &blank;
     }
 
     ilist(const ilist&) = delete;
@@ -105,25 +110,24 @@ public:
      */
     ~ilist() {
         while (!empty()) {
-            pop_back();  // Remove and deallocate all nodes
+            pop_back();  // Remove and delete all nodes
         }
-        alloca.deallocate(blank, 1);
     }
 
-    iterator begin() noexcept { return iterator(blank->next); }
-    iterator end() noexcept { return iterator(blank); }
+    iterator begin() noexcept { return iterator(blank.next); }
+    iterator end() noexcept { return iterator(&blank); }
     
-    const_iterator begin() const noexcept { return const_iterator(blank->next); }
-    const_iterator end() const noexcept { return const_iterator(blank); }
+    const_iterator begin() const noexcept { return const_iterator(blank.next); }
+    const_iterator end() const noexcept { return const_iterator(&blank); }
 
-    reverse_iterator rbegin() noexcept { return reverse_iterator(blank->prev); }
-    reverse_iterator rend() noexcept { return reverse_iterator(blank); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
 
     const_reverse_iterator rbegin() const noexcept { 
-        return const_reverse_iterator(blank->prev); 
+        return const_reverse_iterator(end()); 
     }
     const_reverse_iterator rend() const noexcept { 
-        return const_reverse_iterator(blank); 
+        return const_reverse_iterator(begin()); 
     }
 
     size_type size() const noexcept { return count; }
@@ -143,7 +147,7 @@ public:
      * @return An iterator to the inserted element.
      */
     iterator insert(iterator pos, pointer node) {
-        pointer pos_ = to_address(pos);
+        node_type* pos_ = pos.base();
         node->next = pos_;
         node->prev = pos_->prev;
         pos_->prev->next = node;
@@ -165,7 +169,7 @@ public:
         node->prev->next = node->next;
         node->next->prev = node->prev;
         
-        delete_node(node);
+        delete node;
         --count;
         return pos;
     }
@@ -177,28 +181,29 @@ public:
      * @return An iterator to the element following the removed one. 
      */
     iterator remove(iterator pos) {
-        pos->prev->next = pos->next;
-        pos->next->prev = pos->prev;
+        node_type* node = pos.base();
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
 
         --count;
-        return pos->next;
+        return iterator(node->next);
     }
 
 
     reference front() {
-        return *(blank->next);
+        return *begin();
     }
 
     const_reference front() const {
-        return *(blank->next);
+        return *begin();
     }
 
     reference back() {
-        return *(blank->prev);
+        return *std::prev(end());
     }
 
     const_reference back() const {
-        return *(blank->prev);
+        return *std::prev(end());
     }
 
     /**
@@ -0,0 +1,71 @@
+#ifndef PCC_UTILS_PARALLEL_H
+#define PCC_UTILS_PARALLEL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Call \p fn(i, worker) for every i in [0, n) on up to \p jobs threads
+ *
+ * Indices are handed out one at a time in increasing order, so a slow
+ * item doesn't hold up the items queued behind it on the same thread.
+ * The calling thread takes part in the work and returns once every call
+ * has finished. Calls for different indices may run concurrently, but
+ * never two with the same \p worker, a number in [0, jobs) that names
+ * the thread making the call, so it can index per-thread state.
+ *
+ * @tparam F callable as fn(int, int)
+ * @param n
+ * @param jobs
+ * @param fn
+ */
+template <typename F>
+void parallel_for_worker(int n, int jobs, F fn) {
+    std::atomic<int> next(0);
+    auto work = [&](int worker) {
+        for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;)
+            fn(i, worker);
+    };
+
+    if (jobs > n)
+        jobs = n;
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < jobs; ++i)
+        threads.emplace_back(work, i);
+    work(0);
+    for (std::thread &t : threads)
+        t.join();
+}
+
+
+/**
+ * @brief Call \p fn(i) for every i in [0, n) on up to \p jobs threads
+ *
+ * See parallel_for_worker().
+ *
+ * @tparam F callable as fn(int)
+ * @param n
+ * @param jobs
+ * @param fn
+ */
+template <typename F>
+void parallel_for(int n, int jobs, F fn) {
+    parallel_for_worker(n, jobs, [&](int i, int) { fn(i); });
+}
+
+
+/**
+ * @brief Number of threads the machine can run at once, at least 1
+ *
+ * @return int
+ */
+inline int hardware_jobs() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+
+#endif /* PCC_UTILS_PARALLEL_H */
@@ -0,0 +1,158 @@
+#ifndef PCC_UTILS_SLAB_H
+#define PCC_UTILS_SLAB_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+
+
+/**
+ * @class SlabAllocator
+ * @brief An allocator for many small objects that are freed one by one
+ *        or all at once.
+ *
+ * Objects are carved out of large slabs. A freed object goes on the free
+ * list of its size class, rounded up to a multiple of \c granule, and the
+ * next allocation of that class reuses it. release() (or the destructor)
+ * frees every slab at once.
+ *
+ * Slabs are aligned to their size and start with a pointer to their
+ * allocator, so owner() finds the allocator of any object it handed out.
+ * An allocator must stay where it is while it owns memory.
+ */
+class SlabAllocator {
+private:
+    struct Slab {
+        SlabAllocator *owner;
+        Slab *prev;
+    };
+
+    struct FreeSlot {
+        FreeSlot *next;
+    };
+
+    static constexpr size_t slab_size = 64 * 1024;
+    static constexpr size_t granule = 16;
+    static constexpr size_t num_classes = 32;
+    static constexpr size_t header_size = (sizeof(Slab) + granule - 1) & ~(granule - 1);
+
+    Slab *slabs = nullptr;
+    char *cur = nullptr;
+    char *end = nullptr;
+    FreeSlot *free_lists[num_classes] = {};
+
+    static size_t size_class(size_t size) {
+        return size ? (size - 1) / granule : 0;
+    }
+
+    void grow() {
+        Slab *s = (Slab*)aligned_alloc(slab_size, slab_size);
+        if (!s)
+            throw std::bad_alloc();
+        s->owner = this;
+        s->prev = slabs;
+        slabs = s;
+
+        cur = (char*)s + header_size;
+        end = (char*)s + slab_size;
+    }
+
+public:
+    /// The largest object an allocator can hold.
+    static constexpr size_t max_size = num_classes * granule;
+
+    SlabAllocator() = default;
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    ~SlabAllocator() { release(); }
+
+    /**
+     * @brief Allocate \p size uninitialized bytes aligned to \c granule
+     *
+     * @param size at most \c max_size
+     * @return void*
+     */
+    void *allocate(size_t size) {
+        assert(size <= max_size && "object too large for a slab");
+        size_t c = size_class(size);
+        if (FreeSlot *slot = free_lists[c]) {
+            free_lists[c] = slot->next;
+            return slot;
+        }
+
+        size_t bytes = (c + 1) * granule;
+        if ((size_t)(end - cur) < bytes)
+            grow();
+
+        void *p = cur;
+        cur += bytes;
+        return p;
+    }
+
+    /**
+     * @brief Give back an object for reuse by allocations of its size class
+     *
+     * @param p memory returned by allocate()
+     * @param size the size it was allocated with
+     */
+    void deallocate(void *p, size_t size) {
+        size_t c = size_class(size);
+        FreeSlot *slot = (FreeSlot*)p;
+        slot->next = free_lists[c];
+        free_lists[c] = slot;
+    }
+
+    /**
+     * @brief The allocator that handed out \p p
+     *
+     * @param p memory returned by allocate()
+     * @return SlabAllocator*
+     */
+    static SlabAllocator *owner(void *p) {
+        return ((Slab*)((uintptr_t)p & ~(uintptr_t)(slab_size - 1)))->owner;
+    }
+
+    /**
+     * @brief Free every slab. All memory allocated from the allocator becomes invalid.
+     */
+    void release() {
+        while (slabs) {
+            Slab *prev = slabs->prev;
+            free(slabs);
+            slabs = prev;
+        }
+        cur = end = nullptr;
+        for (FreeSlot *&list : free_lists)
+            list = nullptr;
+    }
+};
+
+
+/**
+ * @class SlabObject
+ * @brief Base of classes whose objects live in a \c SlabAllocator.
+ *
+ * Such objects are made with `new (allocator) T(...)`. Deleting one
+ * destroys it and returns its memory to the allocator it came from;
+ * the destructor has to be virtual for a base pointer to give the
+ * right size.
+ */
+class SlabObject {
+public:
+    static void *operator new(size_t size, SlabAllocator& alloc) {
+        return alloc.allocate(size);
+    }
+
+    static void operator delete(void *p, size_t size) {
+        SlabAllocator::owner(p)->deallocate(p, size);
+    }
+
+    // called if a constructor throws; the memory goes back with the slab
+    static void operator delete(void *, SlabAllocator&) {}
+};
+
+
+#endif /* PCC_UTILS_SLAB_H */